@@ -9,10 +9,33 @@ namespace Input
         GLFWwindow *window = nullptr;
         input_config config;
 
+        // Edges seen since the last frame or tick
+        struct Edges
+        {
+            std::bitset<1024> keysPressed;
+            std::bitset<1024> keysReleased;
+            std::bitset<8> mouseButtonsPressed;
+            std::bitset<8> mouseButtonsReleased;
+
+            void reset()
+            {
+                keysPressed.reset();
+                keysReleased.reset();
+                mouseButtonsPressed.reset();
+                mouseButtonsReleased.reset();
+            }
+        };
+
         std::bitset<1024> keys;
-        std::bitset<1024> keysPressed;
         std::bitset<8> mouseButtons;
-        std::bitset<8> mouseButtonsPressed;
+        Edges frameEdges;
+        Edges tickEdges;
+        bool inTick{false};
+
+        const Edges &edges()
+        {
+            return inTick ? tickEdges : frameEdges;
+        }
 
         glm::vec2 mousePos{0.0f};
         glm::vec2 mouseDelta{0.0f};
@@ -31,11 +54,14 @@ namespace Input
         if (action == GLFW_PRESS)
         {
             keys[key] = true;
-            keysPressed[key] = true;
+            frameEdges.keysPressed[key] = true;
+            tickEdges.keysPressed[key] = true;
         }
         else if (action == GLFW_RELEASE)
         {
             keys[key] = false;
+            frameEdges.keysReleased[key] = true;
+            tickEdges.keysReleased[key] = true;
         }
     }
 
@@ -46,11 +72,14 @@ namespace Input
         if (action == GLFW_PRESS)
         {
             mouseButtons[button] = true;
-            mouseButtonsPressed[button] = true;
+            frameEdges.mouseButtonsPressed[button] = true;
+            tickEdges.mouseButtonsPressed[button] = true;
         }
         else if (action == GLFW_RELEASE)
         {
             mouseButtons[button] = false;
+            frameEdges.mouseButtonsReleased[button] = true;
+            tickEdges.mouseButtonsReleased[button] = true;
         }
     }
 
@@ -98,12 +127,22 @@ namespace Input
 
     void update()
     {
-        keysPressed.reset();
-        mouseButtonsPressed.reset();
+        frameEdges.reset();
         scrollOffset = glm::vec2(0.0f);
         mouseDelta = glm::vec2(0.0f);
     }
 
+    void begin_tick()
+    {
+        inTick = true;
+    }
+
+    void end_tick()
+    {
+        tickEdges.reset();
+        inTick = false;
+    }
+
     void set_cursor_mode(int cursorMode)
     {
         assert(window != nullptr);
@@ -137,7 +176,13 @@ namespace Input
     bool is_key_just_pressed(int key)
     {
         assert(key >= 0 && key < 1024);
-        return keysPressed[key];
+        return edges().keysPressed[key];
+    }
+
+    bool is_key_just_released(int key)
+    {
+        assert(key >= 0 && key < 1024);
+        return edges().keysReleased[key];
     }
 
     bool is_mouse_button_pressed(int button)
@@ -149,7 +194,13 @@ namespace Input
     bool is_mouse_button_just_pressed(int button)
     {
         assert(button >= 0 && button < 8);
-        return mouseButtonsPressed[button];
+        return edges().mouseButtonsPressed[button];
+    }
+
+    bool is_mouse_button_just_released(int button)
+    {
+        assert(button >= 0 && button < 8);
+        return edges().mouseButtonsReleased[button];
     }
 
     glm::vec2 get_mouse_position()
@@ -20,8 +20,16 @@ namespace Input
     void scroll_callback(GLFWwindow *win, double xoffset, double yoffset);
 
     void init(GLFWwindow *win, input_config cfg = {});
+    // Clears the per-frame edges; call once at the end of each frame
     void update();
 
+    // Simulation ticks run zero or more times per frame, so they get their
+    // own edges: between begin_tick and end_tick the just_pressed/released
+    // queries report edges since the previous tick instead of the frame.
+    // An edge is seen by exactly one tick, even across frames with none.
+    void begin_tick();
+    void end_tick();
+
     void set_cursor_mode(int cursor_mode);
     void set_mouse_sensitivity(double sensitivity);
     void set_scroll_sensitivity(double sensitivity);
@@ -29,8 +37,10 @@ namespace Input
 
     bool is_key_pressed(int key);
     bool is_key_just_pressed(int key);
+    bool is_key_just_released(int key);
     bool is_mouse_button_pressed(int button);
     bool is_mouse_button_just_pressed(int button);
+    bool is_mouse_button_just_released(int button);
 
     glm::vec2 get_mouse_position();
     glm::vec2 get_mouse_delta();
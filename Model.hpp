@@ -6,6 +6,7 @@
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
+#include <array>
 #include <cstddef>
 #include <fstream>
 #include <glm/glm.hpp>
@@ -28,6 +29,7 @@ extern entt::dispatcher bus;
 
 struct tCollidables {
     std::vector<glm::mat4> aabbs;
+    uint32_t version = 0; // bumped on every edit so caches know to rebuild
 };
 
 
@@ -64,7 +66,7 @@ struct AABB {
     }
 
     // Get all 8 corners of the AABB
-    std::vector<glm::vec3> getCorners() const {
+    std::array<glm::vec3, 8> getCorners() const {
         return {
             glm::vec3(min.x, min.y, min.z),
             glm::vec3(max.x, min.y, min.z),
@@ -77,17 +79,24 @@ struct AABB {
         };
     }
 
-    // Transform AABB by a matrix
+    // Transform AABB by an affine matrix (Arvo): the new extents are the old
+    // ones multiplied by the absolute 3x3 part, so no corners are visited.
     AABB transform(const glm::mat4& matrix) const {
-        auto corners = getCorners();
-        AABB result;
+        // Empty boxes would give inf - inf = NaN below; they stay empty
+        if (min.x > max.x) return *this;
 
-        for (const auto& corner : corners) {
-            glm::vec4 transformedCorner = matrix * glm::vec4(corner, 1.0f);
-            result.expand(glm::vec3(transformedCorner));
-        }
+        glm::vec3 center = getCenter();
+        glm::vec3 extent = (max - min) * 0.5f;
+
+        glm::vec3 newCenter = glm::vec3(matrix[0]) * center.x +
+                              glm::vec3(matrix[1]) * center.y +
+                              glm::vec3(matrix[2]) * center.z +
+                              glm::vec3(matrix[3]);
+        glm::vec3 newExtent = glm::abs(glm::vec3(matrix[0])) * extent.x +
+                              glm::abs(glm::vec3(matrix[1])) * extent.y +
+                              glm::abs(glm::vec3(matrix[2])) * extent.z;
 
-        return result;
+        return AABB(newCenter - newExtent, newCenter + newExtent);
     }
 
     // Check if point is inside AABB
@@ -1,13 +1,14 @@
 #pragma once
 #include "mygl.h"
 #include "model.hpp"
+#include "shader.hpp"
 
 
 class AABBRenderer {
 private:
   GLuint VAO, VBO, EBO;
   GLuint shaderProgram;
-  GLint mvpLocation;
+  GLint modelLocation;
   GLint colorLocation;
 
   // Cube vertices (unit cube from -0.5 to 0.5)
@@ -34,9 +35,19 @@ private:
   const char *vertexShaderSource = R"(
         #version 330 core
         layout (location = 0) in vec3 aPos;
-        uniform mat4 mvp;
+        uniform mat4 model;
+        // Written once a frame; matches FrameUniforms in frame_uniforms.hpp
+        layout(std140) uniform FrameUniforms {
+            mat4 view;
+            mat4 projection;
+            mat4 viewProjection;
+            vec4 cameraPosition;
+            vec4 viewport;
+            float time;
+            float deltaTime;
+        };
         void main() {
-            gl_Position = mvp * vec4(aPos, 1.0);
+            gl_Position = viewProjection * model * vec4(aPos, 1.0);
         }
     )";
 
@@ -49,50 +60,13 @@ private:
         }
     )";
 
-  GLuint compileShader(GLenum type, const char *source) {
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, nullptr);
-    glCompileShader(shader);
-
-    // Check compilation
-    int success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-      char infoLog[512];
-      glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-      // Handle error (print or throw)
-    }
-    return shader;
-  }
-
 public:
   AABBRenderer() {
-    // Create and compile shaders
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fragmentShader =
-        compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-
-    // Create shader program
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    // Check linking
-    int success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-      char infoLog[512];
-      glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
-      // Handle error
-    }
-
-    // Clean up shaders
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    shaderProgram =
+        Shader::CreateFromSource(vertexShaderSource, fragmentShaderSource);
 
     // Get uniform locations
-    mvpLocation = glGetUniformLocation(shaderProgram, "mvp");
+    modelLocation = glGetUniformLocation(shaderProgram, "model");
     colorLocation = glGetUniformLocation(shaderProgram, "color");
 
     // Create VAO, VBO, EBO
@@ -126,8 +100,8 @@ public:
     glDeleteProgram(shaderProgram);
   }
 
-  // Draw AABB wireframe
-  void drawAABB(const AABB &aabb, const glm::mat4 &viewProjectionMatrix,
+  // Draw AABB wireframe, with the frame's view and projection
+  void drawAABB(const AABB &aabb,
                 const glm::vec3 &color = glm::vec3(1.0f, 1.0f, 0.0f)) {
 
     // Create transform matrix for this AABB
@@ -138,11 +112,9 @@ public:
     model = glm::translate(model, center);
     model = glm::scale(model, size);
 
-    glm::mat4 mvp = viewProjectionMatrix * model;
-
     // Use shader program
     glUseProgram(shaderProgram);
-    glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, &mvp[0][0]);
+    glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &model[0][0]);
     glUniform3fv(colorLocation, 1, &color[0]);
 
     // Draw wireframe
@@ -151,14 +123,11 @@ public:
     glBindVertexArray(0);
   }
 
-  void drawAABB2(const glm::mat4 model, const glm::mat4 &viewProjectionMatrix,
+  void drawAABB2(const glm::mat4 model,
                 const glm::vec3 &color = glm::vec3(1.0f, 1.0f, 0.0f)) {
-
-      glm::mat4 mvp = viewProjectionMatrix * model;
-
     // Use shader program
     glUseProgram(shaderProgram);
-    glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, &mvp[0][0]);
+    glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &model[0][0]);
     glUniform3fv(colorLocation, 1, &color[0]);
 
     // Draw wireframe
@@ -168,8 +137,7 @@ public:
   }
 
   // Draw multiple AABBs with different colors
-  void drawAABBs(const std::vector<std::pair<AABB, glm::vec3>> &aabbs,
-                 const glm::mat4 &viewProjectionMatrix) {
+  void drawAABBs(const std::vector<std::pair<AABB, glm::vec3>> &aabbs) {
     glUseProgram(shaderProgram);
     glBindVertexArray(VAO);
 
@@ -181,9 +149,7 @@ public:
       model = glm::translate(model, center);
       model = glm::scale(model, size);
 
-      glm::mat4 mvp = viewProjectionMatrix * model;
-
-      glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, &mvp[0][0]);
+      glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &model[0][0]);
       glUniform3fv(colorLocation, 1, &color[0]);
 
       glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, 0);
@@ -147,17 +147,19 @@ public:
        shaderProgram = Shader::Create(resources::path(resources::Shaders_animation_vertex), resources::path(resources::Shaders_animation_fragment));
     }
 
-    void render(const glm::mat4& view, const glm::mat4& projection) {
+    // timeOffset shifts the pose back from the last simulated time, so the
+    // renderer can blend between fixed ticks
+    void render(float timeOffset = 0.0f) {
         glUseProgram(shaderProgram);
 
+        float time = animationTime + timeOffset;
+        if (time < 0.0f) time += animationDuration;
+
         // Update bone transformations
         std::vector<glm::mat4> boneTransforms(100, glm::mat4(1.0f)); // Max 100 bones
-        calculateBoneTransformations(animationTime, boneTransforms);
-
-        // Set uniforms
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        calculateBoneTransformations(time, boneTransforms);
 
+        // Set uniforms; view and projection come from the frame's uniform block
         glm::mat4 model = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f)); // Try scaling if model is too small
         glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
 
@@ -0,0 +1,854 @@
+#include "benchmarks.hpp"
+#include "bounds.hpp"
+#include "camera.hpp"
+#include "collider_store.hpp"
+#include "collision_system.hpp"
+#include "narrowphase.hpp"
+#include "particle_collision.hpp"
+#include "particle_simulation.hpp"
+#include "particle_sort.hpp"
+#include "culling.hpp"
+#include "heightfield.hpp"
+#include "sdf.hpp"
+#include "model.hpp"
+#include "job_system.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using BenchClock = std::chrono::steady_clock;
+
+// Best-of-N wall time in milliseconds, after one warm-up run
+static double time_best_ms(int iterations, const std::function<void()>& fn) {
+    fn();
+    double best = 1e30;
+    for (int i = 0; i < iterations; i++) {
+        auto start = BenchClock::now();
+        fn();
+        std::chrono::duration<double, std::milli> elapsed = BenchClock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// Random boxes spread over a cube of the given half-size, seeded so runs compare
+static std::vector<AABB> make_synthetic_scene(size_t count, float halfExtent, unsigned int seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> pos(-halfExtent, halfExtent);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+
+    std::vector<AABB> boxes;
+    boxes.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        glm::vec3 center(pos(gen), pos(gen) * 0.1f, pos(gen));
+        glm::vec3 half(size(gen), size(gen), size(gen));
+        boxes.emplace_back(center - half, center + half);
+    }
+    return boxes;
+}
+
+// === Culling ===
+static void bench_cull() {
+    const size_t objectCount = 1000000;
+    std::vector<AABB> scene = make_synthetic_scene(objectCount, 1000.0f, 1234);
+
+    Camera camera(glm::vec3(0.0f, 10.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 16.0f / 9.0f, 0.1f, 1000.0f);
+    camera.CalculateFrustum(projection, camera.GetViewMatrix());
+
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "cull: " << objectCount << " objects, 1.." << maxThreads << " threads" << std::endl;
+
+    BoundsSoA sceneSoA;
+    sceneSoA.resize(scene.size());
+    for (size_t i = 0; i < scene.size(); i++) {
+        sceneSoA.set(i, scene[i]);
+    }
+
+    double baseline = 0.0;
+    for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+        JobSystem jobs(threads);
+        CullScratch scratch;
+        std::vector<uint32_t> visible;
+
+        double ms = time_best_ms(10, [&] {
+            cull_parallel(jobs, scene.data(), scene.size(), camera.ViewFrustum, scratch, visible);
+        });
+        double msSoA = time_best_ms(10, [&] {
+            cull_parallel(jobs, sceneSoA, camera.ViewFrustum, scratch, visible);
+        });
+        if (threads == 1) baseline = ms;
+
+        std::printf("  threads %2u: aos %8.3f ms  %6.2fx   soa %8.3f ms  %6.2fx  (%zu visible)\n",
+                    threads, ms, baseline / ms, msSoA, baseline / msSoA, visible.size());
+    }
+}
+
+// === AABB transform ===
+
+// The original AABB::transform: heap-allocated corners, eight full mat4 products
+static AABB legacy_transform(const AABB& aabb, const glm::mat4& matrix) {
+    std::vector<glm::vec3> corners = {
+        glm::vec3(aabb.min.x, aabb.min.y, aabb.min.z), glm::vec3(aabb.max.x, aabb.min.y, aabb.min.z),
+        glm::vec3(aabb.min.x, aabb.max.y, aabb.min.z), glm::vec3(aabb.max.x, aabb.max.y, aabb.min.z),
+        glm::vec3(aabb.min.x, aabb.min.y, aabb.max.z), glm::vec3(aabb.max.x, aabb.min.y, aabb.max.z),
+        glm::vec3(aabb.min.x, aabb.max.y, aabb.max.z), glm::vec3(aabb.max.x, aabb.max.y, aabb.max.z)};
+    AABB result;
+    for (const auto& corner : corners) {
+        result.expand(glm::vec3(matrix * glm::vec4(corner, 1.0f)));
+    }
+    return result;
+}
+
+static void bench_aabb() {
+    const size_t count = 100000;
+    std::vector<AABB> local = make_synthetic_scene(count, 10.0f, 99);
+    std::vector<glm::mat4> transforms(count);
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (auto& m : transforms) {
+        glm::vec3 axis = glm::normalize(glm::vec3(unit(gen), unit(gen), unit(gen)) + glm::vec3(0.0f, 2.0f, 0.0f));
+        m = glm::translate(glm::mat4(1.0f), glm::vec3(unit(gen), unit(gen), unit(gen)) * 100.0f);
+        m = glm::rotate(m, unit(gen) * 3.14159f, axis);
+        m = glm::scale(m, glm::vec3(1.0f + unit(gen) * 0.5f));
+    }
+
+    std::vector<AABB> out(count);
+    BoundsSoA outSoA;
+    outSoA.resize(count);
+
+    double legacy = time_best_ms(10, [&] {
+        for (size_t i = 0; i < count; i++) out[i] = legacy_transform(local[i], transforms[i]);
+    });
+    double arvo = time_best_ms(10, [&] {
+        for (size_t i = 0; i < count; i++) out[i] = local[i].transform(transforms[i]);
+    });
+    double batch = time_best_ms(10, [&] {
+        update_world_bounds(transforms.data(), local.data(), 0, count, outSoA);
+    });
+
+    // The corner method and Arvo's method give the same box up to rounding
+    float maxError = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        AABB expected = legacy_transform(local[i], transforms[i]);
+        AABB batched = outSoA.get(i);
+        maxError = std::max(maxError, glm::length(expected.min - batched.min));
+        maxError = std::max(maxError, glm::length(expected.max - batched.max));
+    }
+
+    std::cout << "aabb transform: " << count << " boxes" << std::endl;
+    std::printf("  corners + vector : %8.3f ms  %7.1f ns/box\n", legacy, legacy * 1e6 / count);
+    std::printf("  arvo scalar      : %8.3f ms  %7.1f ns/box  %6.2fx\n", arvo, arvo * 1e6 / count, legacy / arvo);
+    std::printf("  arvo batch simd  : %8.3f ms  %7.1f ns/box  %6.2fx\n", batch, batch * 1e6 / count, legacy / batch);
+    std::printf("  max error vs corners: %g\n", maxError);
+}
+
+// === Collider broadphase ===
+static void bench_colliders() {
+    const int queries = 100000;
+    std::cout << "collider point queries: " << queries << " per run" << std::endl;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    for (size_t count : {10, 100, 1000, 10000, 50000}) {
+        // Town-like layout: boxes of a few metres over an area that grows
+        // with the collider count so density stays about the same
+        float halfArea = 10.0f * std::sqrt(static_cast<float>(count));
+        tCollidables colliders;
+        for (size_t i = 0; i < count; i++) {
+            glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(unit(gen) * halfArea, 0.0f, unit(gen) * halfArea));
+            m = glm::rotate(m, unit(gen) * 3.14159f, glm::vec3(0, 1, 0));
+            m = glm::scale(m, glm::vec3(1.0f + unit(gen) * 0.5f, 2.0f, 1.0f + unit(gen) * 0.5f));
+            colliders.aabbs.push_back(m);
+        }
+
+        std::vector<glm::vec3> points(queries);
+        for (auto& p : points) p = glm::vec3(unit(gen) * halfArea, 1.0f, unit(gen) * halfArea);
+
+        ColliderStore store;
+        store.sync(colliders);
+        std::vector<uint32_t> nearby;
+        int hits = 0;
+
+        double grid = time_best_ms(5, [&] {
+            hits = 0;
+            for (const auto& p : points) {
+                nearby.clear();
+                store.query(AABB(p, p), nearby);
+                for (uint32_t index : nearby) {
+                    if (store.getBounds(index).contains(p)) { hits++; break; }
+                }
+            }
+        });
+
+        // What collision_system_update used to do per query
+        const AABB base(glm::vec3(-1.0f), glm::vec3(1.0f));
+        int linearHits = 0;
+        double linear = time_best_ms(1, [&] {
+            linearHits = 0;
+            for (int q = 0; q < 1000; q++) {
+                for (const auto& m : colliders.aabbs) {
+                    if (base.transform(m).contains(points[q])) { linearHits++; break; }
+                }
+            }
+        }) * (queries / 1000.0);
+
+        std::printf("  %6zu colliders: grid %8.2f ns/query   linear %10.2f ns/query  (%d hits, %d in first 1000)\n",
+                    count, grid * 1e6 / queries, linear * 1e6 / queries, hits, linearHits);
+    }
+}
+
+// === Narrowphase ===
+static void bench_narrowphase() {
+    const size_t count = 100000;
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    std::vector<OBB> boxes(count);
+    std::vector<Capsule> capsules(count);
+    std::vector<glm::vec3> deltas(count);
+    for (size_t i = 0; i < count; i++) {
+        glm::mat4 m = glm::rotate(glm::mat4(1.0f), unit(gen) * 3.14159f,
+                                  glm::normalize(glm::vec3(unit(gen), 1.0f, unit(gen))));
+        m = glm::scale(m, glm::vec3(1.0f + unit(gen) * 0.5f, 1.0f + unit(gen) * 0.5f, 0.5f + unit(gen) * 0.25f));
+        boxes[i] = OBB::fromTransform(m, 1.0f);
+        glm::vec3 p(unit(gen) * 3.0f, unit(gen) * 3.0f, unit(gen) * 3.0f);
+        capsules[i] = {p - glm::vec3(0.0f, 0.75f, 0.0f), p, 0.25f};
+        deltas[i] = -p * (1.0f + unit(gen));
+    }
+
+    int contacts = 0;
+    int hits = 0;
+    double contactMs = time_best_ms(5, [&] {
+        contacts = 0;
+        for (size_t i = 0; i < count; i++) {
+            Contact c;
+            contacts += capsule_obb_contact(capsules[i], boxes[i], c);
+        }
+    });
+    double sweepMs = time_best_ms(5, [&] {
+        hits = 0;
+        for (size_t i = 0; i < count; i++) {
+            SweepHit h;
+            hits += sweep_capsule_obb(capsules[i], deltas[i], boxes[i], h);
+        }
+    });
+
+    std::cout << "narrowphase: capsule vs OBB, " << count << " pairs" << std::endl;
+    std::printf("  contact : %8.2f ns/pair  %8.2f M pairs/s  (%d overlapping)\n",
+                contactMs * 1e6 / count, count / (contactMs * 1e3), contacts);
+    std::printf("  sweep   : %8.2f ns/pair  %8.2f M pairs/s  (%d hits)\n",
+                sweepMs * 1e6 / count, count / (sweepMs * 1e3), hits);
+
+    // Tunneling check: sprint at a 5 cm thick rotated wall on a 30 Hz tick.
+    // Each step moves 2 m, forty times the wall thickness.
+    tCollidables wall;
+    glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, -10.0f));
+    m = glm::rotate(m, 0.3f, glm::vec3(0, 1, 0));
+    wall.aabbs.push_back(glm::scale(m, glm::vec3(50.0f, 2.0f, 0.025f)));
+    ColliderStore store;
+    store.sync(wall);
+
+    PlayerShape shape;
+    glm::vec3 position(0.0f, 1.0f, 0.0f);
+    const float tick = 1.0f / 30.0f;
+    for (int step = 0; step < 30; step++) {
+        position = collision_move_and_slide(store, shape, position, glm::vec3(0.0f, 0.0f, -60.0f) * tick);
+    }
+    glm::vec3 local = store.getOBB(0).toLocal(position);
+    std::printf("  30 Hz sprint at thin wall: stopped %s the wall (local z = %.3f), slid to x = %.2f\n",
+                local.z > 0.0f ? "in front of" : "BEHIND", local.z, position.x);
+}
+
+// === Heightfield ===
+static void add_quad(std::vector<glm::vec3>& tris, glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d) {
+    tris.insert(tris.end(), {a, b, c, a, c, d});
+}
+
+// Highest surface at most maxStepUp above p by testing every triangle, the
+// per-frame cost the bake replaces
+static bool raycast_ground(const std::vector<glm::vec3>& tris, const glm::vec3& p, float maxStepUp, float& height) {
+    bool found = false;
+    float limit = p.y + maxStepUp;
+    for (size_t t = 0; t + 2 < tris.size(); t += 3) {
+        const glm::vec3 &a = tris[t], &b = tris[t + 1], &c = tris[t + 2];
+        float area = (b.x - a.x) * (c.z - a.z) - (c.x - a.x) * (b.z - a.z);
+        if (std::fabs(area) < 1e-12f) continue;
+        float w1 = ((p.x - a.x) * (c.z - a.z) - (c.x - a.x) * (p.z - a.z)) / area;
+        float w2 = ((b.x - a.x) * (p.z - a.z) - (p.x - a.x) * (b.z - a.z)) / area;
+        if (w1 < 0.0f || w2 < 0.0f || w1 + w2 > 1.0f) continue;
+        float h = (1.0f - w1 - w2) * a.y + w1 * b.y + w2 * c.y;
+        if (h <= limit && (!found || h > height)) {
+            height = h;
+            found = true;
+        }
+    }
+    return found;
+}
+
+static void bench_heightfield() {
+    // Rolling 256 m terrain on a 1 m grid, with 4 m high slabs crossing it
+    const int size = 256;
+    std::vector<glm::vec3> tris;
+    auto terrain = [](float x, float z) { return 2.0f * std::sin(x * 0.05f) * std::cos(z * 0.07f); };
+    for (int z = 0; z < size; z++) {
+        for (int x = 0; x < size; x++) {
+            float x0 = x, x1 = x + 1.0f, z0 = z, z1 = z + 1.0f;
+            add_quad(tris, {x0, terrain(x0, z0), z0}, {x1, terrain(x1, z0), z0},
+                     {x1, terrain(x1, z1), z1}, {x0, terrain(x0, z1), z1});
+        }
+    }
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<float> pos(0.0f, size - 16.0f);
+    for (int i = 0; i < 64; i++) {
+        float x = pos(gen), z = pos(gen);
+        for (float y : {6.0f, 5.5f}) {
+            add_quad(tris, {x, y, z}, {x + 16.0f, y, z}, {x + 16.0f, y, z + 3.0f}, {x, y, z + 3.0f});
+        }
+    }
+
+    Heightfield field;
+    HeightfieldBakeSettings settings;
+    double bakeMs = time_best_ms(3, [&] { field = heightfield_bake(tris, settings); });
+
+    const size_t queryCount = 1000000;
+    std::uniform_real_distribution<float> inside(1.0f, size - 1.0f);
+    std::uniform_real_distribution<float> up(0.0f, 7.0f);
+    std::vector<glm::vec3> points(queryCount);
+    for (auto& p : points) p = glm::vec3(inside(gen), up(gen), inside(gen));
+
+    int grounded = 0;
+    double queryMs = time_best_ms(5, [&] {
+        grounded = 0;
+        for (const auto& p : points) {
+            float h;
+            glm::vec3 n;
+            grounded += field.query(p, 0.5f, h, n);
+        }
+    });
+
+    // Brute force is slow, so only a slice of the points, which doubles as
+    // an accuracy check against the bake
+    const size_t rayCount = 200;
+    float maxError = 0.0f;
+    double rayMs = time_best_ms(1, [&] {
+        for (size_t i = 0; i < rayCount; i++) {
+            float exact, baked;
+            glm::vec3 n;
+            if (raycast_ground(tris, points[i], 0.5f, exact) && field.query(points[i], 0.5f, baked, n)) {
+                maxError = std::max(maxError, std::fabs(exact - baked));
+            }
+        }
+    });
+
+    std::cout << "heightfield: " << tris.size() / 3 << " triangles -> " << field.width << "x" << field.depth
+              << "x" << field.layers << " cells (" << field.heights.size() * sizeof(float) / (1024 * 1024) << " MB)" << std::endl;
+    std::printf("  bake     : %8.2f ms\n", bakeMs);
+    std::printf("  query    : %8.2f ns/query  (%d of %zu on ground)\n", queryMs * 1e6 / queryCount, grounded, queryCount);
+    std::printf("  raycast  : %8.2f us/query  (max height error of bake %.4f)\n", rayMs * 1e3 / rayCount, maxError);
+}
+
+// === Job system ===
+struct BenchBody {
+    glm::vec3 position;
+    glm::vec3 velocity;
+};
+
+// Deliberately ALU heavy so scaling is not hidden behind memory bandwidth
+static void integrate_body(BenchBody& body, float dt) {
+    for (int step = 0; step < 8; step++) {
+        glm::vec3 toCenter = -body.position;
+        float distSq = glm::dot(toCenter, toCenter) + 0.01f;
+        body.velocity += toCenter * (dt / (distSq * std::sqrt(distSq)));
+        body.position += body.velocity * dt;
+    }
+}
+
+static void bench_jobs() {
+    const size_t bodyCount = 1 << 20;
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<BenchBody> initial(bodyCount);
+    for (auto& body : initial) {
+        body.position = glm::vec3(unit(gen), unit(gen), unit(gen)) * 10.0f;
+        body.velocity = glm::vec3(unit(gen), unit(gen), unit(gen));
+    }
+
+    entt::registry registry;
+    for (size_t i = 0; i < 100000; i++) {
+        registry.emplace<BenchBody>(registry.create(), initial[i]);
+    }
+    auto view = registry.view<BenchBody>();
+
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "jobs: " << bodyCount << " bodies, 1.." << maxThreads << " threads" << std::endl;
+
+    double baseFor = 0.0, baseGraph = 0.0, baseView = 0.0;
+    for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+        JobSystem jobs(threads);
+        std::vector<BenchBody> bodies = initial;
+
+        double forMs = time_best_ms(5, [&] {
+            jobs.parallel_for(bodies.size(), 1024, [&](size_t begin, size_t end, unsigned int) {
+                for (size_t i = begin; i < end; i++) integrate_body(bodies[i], 0.001f);
+            });
+        });
+
+        // Frame-shaped graph: eight independent systems, each fanning out over
+        // its slice, then a reduction that depends on all of them
+        double graphMs = time_best_ms(5, [&] {
+            const size_t systems = 8;
+            const size_t slice = bodies.size() / systems;
+            JobCounter stage;
+            JobCounter reduce;
+            float sums[systems] = {};
+            for (size_t s = 0; s < systems; s++) {
+                jobs.run([&, s] {
+                    jobs.parallel_for(slice, 1024, [&](size_t begin, size_t end, unsigned int) {
+                        for (size_t i = begin; i < end; i++) integrate_body(bodies[s * slice + i], 0.001f);
+                    });
+                    for (size_t i = 0; i < slice; i += 64) sums[s] += bodies[s * slice + i].position.x;
+                }, &stage);
+            }
+            float total = 0.0f;
+            jobs.run_after(stage, [&] { for (float sum : sums) total += sum; }, &reduce);
+            jobs.wait(reduce);
+        });
+
+        double viewMs = time_best_ms(5, [&] {
+            jobs.parallel_for_view(view, 256, [&](entt::entity entity, unsigned int) {
+                integrate_body(view.get<BenchBody>(entity), 0.001f);
+            });
+        });
+
+        if (threads == 1) {
+            baseFor = forMs;
+            baseGraph = graphMs;
+            baseView = viewMs;
+        }
+        std::printf("  threads %2u: parallel_for %8.2f ms %5.2fx   graph %8.2f ms %5.2fx   view %7.2f ms %5.2fx\n",
+                    threads, forMs, baseFor / forMs, graphMs, baseGraph / graphMs, viewMs, baseView / viewMs);
+    }
+}
+
+// === Particles ===
+struct LegacyParticle {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    glm::vec4 color;
+    float life;
+    float size;
+    float rotation;
+    float rotationSpeed;
+};
+
+// ParticleEmitter::update as it was: AoS storage, erase() on death and a
+// second pass to build the instances
+static void legacy_particle_update(std::vector<LegacyParticle>& particles, const ParticleEmitterConfig& config,
+                                   float deltaTime, std::vector<ParticleInstanceData>& instanceData) {
+    for (auto it = particles.begin(); it != particles.end();) {
+        LegacyParticle& p = *it;
+        p.velocity += config.gravity * deltaTime;
+        p.velocity *= config.damping;
+        p.position += p.velocity * deltaTime;
+        p.rotation += p.rotationSpeed * deltaTime;
+        p.life -= deltaTime;
+        if (p.life <= 0.0f) {
+            it = particles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    instanceData.clear();
+    for (const auto& particle : particles) {
+        float lifeRatio = particle.life / config.particleLifetime;
+        ParticleInstanceData data;
+        data.worldPosition = particle.position;
+        data.color = glm::mix(config.endColor, config.startColor, lifeRatio);
+        data.size = glm::mix(config.endSize, config.startSize, lifeRatio) * particle.size;
+        data.rotation = particle.rotation;
+        instanceData.push_back(data);
+    }
+}
+
+static void bench_particles() {
+    ParticleEmitterConfig config;
+    config.particleLifetime = 2.0f;
+    const float dt = 1.0f / 60.0f;
+
+    std::cout << "particles: one 60 Hz update incl. instance build, lives spread over 0.." << config.particleLifetime
+              << " s (about 1 in 120 dies per update)" << std::endl;
+
+    for (size_t count : {size_t(1000), size_t(100000), size_t(1000000)}) {
+        std::mt19937 gen(9);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> lifeDist(0.0f, config.particleLifetime);
+
+        ParticleSoA soa;
+        soa.reserve(count);
+        std::vector<LegacyParticle> legacy;
+        legacy.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            glm::vec3 position(unit(gen), unit(gen), unit(gen));
+            glm::vec3 velocity(unit(gen), unit(gen) + 1.0f, unit(gen));
+            float life = lifeDist(gen);
+            float size = config.startSize + unit(gen) * config.sizeVariance;
+            float rotation = unit(gen) * 3.14159f;
+            float spin = unit(gen);
+            soa.push(position, velocity, life, size, rotation, spin);
+            legacy.push_back({position, velocity, config.startColor, life, size, rotation, spin});
+        }
+
+        // Each run starts from the same state; copying it is not timed
+        std::vector<ParticleInstanceData> instances(count);
+        ParticleSoA soaRun;
+        double soaMs = 1e30;
+        size_t written = 0;
+        for (int run = 0; run < 5; run++) {
+            soaRun = soa;
+            auto start = BenchClock::now();
+            written = particles_update(soaRun, config, dt, instances.data());
+            soaMs = std::min(soaMs, std::chrono::duration<double, std::milli>(BenchClock::now() - start).count());
+        }
+
+        // Erase-per-death is quadratic; one run at 1M already takes seconds
+        std::vector<LegacyParticle> legacyRun;
+        std::vector<ParticleInstanceData> legacyInstances;
+        legacyInstances.reserve(count);
+        double legacyMs = 1e30;
+        int legacyRuns = count >= 1000000 ? 1 : 5;
+        for (int run = 0; run < legacyRuns; run++) {
+            legacyRun = legacy;
+            auto start = BenchClock::now();
+            legacy_particle_update(legacyRun, config, dt, legacyInstances);
+            legacyMs = std::min(legacyMs, std::chrono::duration<double, std::milli>(BenchClock::now() - start).count());
+        }
+
+        std::printf("  %8zu: legacy %10.3f ms %10.0f p/ms   soa %8.3f ms %10.0f p/ms  %7.1fx  (%zu alive, %s)\n",
+                    count, legacyMs, count / legacyMs, soaMs, count / soaMs, legacyMs / soaMs, written,
+                    written == legacyInstances.size() ? "match" : "MISMATCH");
+    }
+}
+
+// One particle at a time through std::mt19937, as spawnParticle did
+static void legacy_particle_spawn(std::vector<LegacyParticle>& particles, const ParticleEmitterConfig& config,
+                                  std::mt19937& gen, std::uniform_real_distribution<float>& dis) {
+    auto randomFloat = [&](float min, float max) { return min + dis(gen) * (max - min); };
+    auto randomVec3 = [&](const glm::vec3& base, const glm::vec3& variance) {
+        return glm::vec3(base.x + randomFloat(-variance.x, variance.x),
+                         base.y + randomFloat(-variance.y, variance.y),
+                         base.z + randomFloat(-variance.z, variance.z));
+    };
+
+    LegacyParticle p;
+    p.position = randomVec3(config.spawnPosition, config.spawnPositionVariance);
+    p.velocity = randomVec3(config.initialVelocity, config.velocityVariance);
+    p.life = config.particleLifetime + randomFloat(-config.lifetimeVariance, config.lifetimeVariance);
+    p.size = config.startSize + randomFloat(-config.sizeVariance, config.sizeVariance);
+    p.rotation = randomFloat(0.0f, 2.0f * 3.14159265f);
+    p.rotationSpeed = config.rotationSpeed + randomFloat(-config.rotationVariance, config.rotationVariance);
+    p.color = config.startColor;
+    particles.push_back(p);
+}
+
+static void bench_spawn() {
+    const size_t count = 1000000;
+    ParticleEmitterConfig config;
+
+    std::vector<LegacyParticle> legacy;
+    legacy.reserve(count);
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+    double legacyMs = time_best_ms(3, [&] {
+        legacy.clear();
+        for (size_t i = 0; i < count; i++) legacy_particle_spawn(legacy, config, gen, dis);
+    });
+
+    ParticleSoA soa;
+    soa.reserve(count);
+    Rng4 rng(42);
+    double batchMs = time_best_ms(3, [&] {
+        soa.clear();
+        particles_spawn(soa, config, count, rng);
+    });
+
+    // Explosion-style bursts: 17 particles per 60 Hz frame at 1000/s
+    double burstMs = time_best_ms(3, [&] {
+        soa.clear();
+        while (soa.count + 17 <= count) particles_spawn(soa, config, 17, rng);
+    });
+
+    // Same seed, same particles
+    ParticleSoA a, b;
+    a.reserve(1000);
+    b.reserve(1000);
+    Rng4 rngA(7), rngB(7);
+    particles_spawn(a, config, 1000, rngA);
+    particles_spawn(b, config, 1000, rngB);
+    bool reproducible = a.posX == b.posX && a.velY == b.velY && a.life == b.life;
+
+    // Spread check: mean of the unit draws should sit near 0.5
+    double sum = 0.0;
+    for (int i = 0; i < 1000000; i++) sum += rng.next();
+
+    std::cout << "spawn: " << count << " particles" << std::endl;
+    std::printf("  mt19937 per particle : %8.2f ms  %8.0f p/ms\n", legacyMs, count / legacyMs);
+    std::printf("  xoshiro128+ batch    : %8.2f ms  %8.0f p/ms  %6.1fx\n", batchMs, count / batchMs, legacyMs / batchMs);
+    std::printf("  bursts of 17         : %8.2f ms  %8.0f p/ms  %6.1fx\n", burstMs, soa.count / burstMs,
+                legacyMs / burstMs);
+    std::printf("  seeded replay %s, mean of 1M draws %.4f\n", reproducible ? "identical" : "DIFFERS", sum / 1e6);
+}
+
+// Smoke-like emitter and an orbiting camera; each mode runs the same
+// frames and reports the average sort cost and how out of order the
+// result is (adjacent pairs more than 5 cm the wrong way round, about half a default particle)
+static void bench_sort_case(size_t count, float orbitSpeed) {
+    const int frames = 240;
+    const float dt = 1.0f / 60.0f;
+
+    ParticleEmitterConfig config;
+    config.maxParticles = count;
+    config.emissionRate = count / 3.0f;
+    config.particleLifetime = 3.0f;
+    config.spawnPositionVariance = glm::vec3(5.0f, 1.0f, 5.0f);
+    config.velocityVariance = glm::vec3(1.0f);
+    config.gravity = glm::vec3(0.0f, 0.5f, 0.0f);
+
+    struct Mode {
+        const char* name;
+        ParticleSortMode mode;
+        size_t budget;
+    };
+    const Mode modes[] = {
+        {"std::sort by depth ", ParticleSortMode::Off, 0},
+        {"radix every frame  ", ParticleSortMode::Full, 0},
+        {"coherent           ", ParticleSortMode::Coherent, 0},
+        {"budgeted count/4   ", ParticleSortMode::Budgeted, count / 4},
+    };
+
+    std::cout << "  " << count << " particles, orbit " << orbitSpeed << " rad/frame" << std::endl;
+    for (const Mode& mode : modes) {
+        ParticleSoA soa;
+        soa.reserve(count);
+        Rng4 rng(3);
+        std::vector<ParticleInstanceData> pool(count);
+        ParticleDepthSorter sorter;
+        std::vector<uint32_t> reference;
+        float spawnDebt = 0.0f;
+
+        double totalMs = 0.0;
+        size_t inversions = 0, checked = 0, radixFrames = 0;
+        for (int frame = 0; frame < frames; frame++) {
+            spawnDebt += config.emissionRate * dt;
+            spawnDebt -= particles_spawn(soa, config, static_cast<size_t>(spawnDebt), rng);
+            size_t live = particles_update(soa, config, dt, pool.data());
+
+            float angle = frame * orbitSpeed;
+            glm::vec3 eye(20.0f * std::cos(angle), 4.0f, 20.0f * std::sin(angle));
+            glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            auto depth = [&](uint32_t id) {
+                const glm::vec3& p = pool[id].worldPosition;
+                return view[0][2] * p.x + view[1][2] * p.y + view[2][2] * p.z + view[3][2];
+            };
+
+            ParticleDepthSorter::Range range{0, static_cast<uint32_t>(live)};
+            const std::vector<uint32_t>* order;
+            auto start = BenchClock::now();
+            if (mode.mode == ParticleSortMode::Off) {
+                reference.resize(live);
+                for (uint32_t i = 0; i < live; i++) reference[i] = i;
+                std::sort(reference.begin(), reference.end(), [&](uint32_t a, uint32_t b) { return depth(a) < depth(b); });
+                order = &reference;
+            } else {
+                order = &sorter.sort(pool.data(), &range, 1, view, mode.mode, mode.budget);
+            }
+            totalMs += std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+            radixFrames += mode.mode != ParticleSortMode::Off && sorter.getStats().radix;
+
+            for (size_t i = 1; i < order->size(); i++) {
+                inversions += depth((*order)[i - 1]) > depth((*order)[i]) + 0.05f;
+            }
+            checked += order->size();
+        }
+
+        std::printf("    %s: %7.3f ms/frame  out of order %6.3f%%  radix frames %3zu\n", mode.name,
+                    totalMs / frames, 100.0 * inversions / std::max<size_t>(checked, 1), radixFrames);
+    }
+}
+
+static void bench_sort() {
+    std::cout << "sort: back-to-front, 240 frames" << std::endl;
+    bench_sort_case(100000, 0.01f);
+    bench_sort_case(5000, 0.01f);
+    bench_sort_case(5000, 0.0f);
+}
+
+// One update of count particles bouncing around a box-filled town, spread
+// over a cube of the given half-size, with the colliders gathered the way
+// ParticleEmitter does
+static void bench_particle_collision_case(ColliderStore& store, const glm::vec3& center, float spread, size_t count) {
+    ParticleEmitterConfig config;
+    config.particleLifetime = 2.0f;
+    config.collision = ParticleCollision::Bounce;
+    const float dt = 1.0f / 60.0f;
+
+    std::mt19937 gen(21);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    ParticleSoA soa;
+    soa.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        glm::vec3 position = center + glm::vec3(unit(gen), unit(gen) * 0.5f + 0.5f, unit(gen)) * spread;
+        glm::vec3 velocity(unit(gen) * 4.0f, unit(gen) * 4.0f, unit(gen) * 4.0f);
+        soa.push(position, velocity, 1.0f + unit(gen) * 0.5f, config.startSize, 0.0f, 0.0f);
+    }
+    const AABB region(center - glm::vec3(spread + 1.0f, 1.0f, spread + 1.0f),
+                      center + glm::vec3(spread + 1.0f, 2.0f * spread + 1.0f, spread + 1.0f));
+
+    std::vector<ParticleInstanceData> instances(count);
+    ParticleSoA run;
+    ParticleColliders colliders;
+    auto timed = [&](ParticleColliders* nearby) {
+        double best = 1e30;
+        for (int r = 0; r < 5; r++) {
+            run = soa;
+            auto start = BenchClock::now();
+            if (nearby) nearby->gather(store, region);
+            particles_update(run, config, dt, instances.data(), nearby);
+            best = std::min(best, std::chrono::duration<double, std::milli>(BenchClock::now() - start).count());
+        }
+        return best;
+    };
+
+    colliders.gather(store, region);
+    size_t candidates = colliders.nearby.size();
+    bool batched = colliders.store == nullptr;
+    double off = timed(nullptr);
+    double on = timed(&colliders);
+
+    // Every particle against every collider, through the same SIMD reject
+    ParticleColliders all;
+    all.bounds.resize(store.size());
+    for (uint32_t i = 0; i < store.size(); i++) {
+        all.bounds.set(i, store.getBounds(i));
+        all.boxes.push_back(store.getOBB(i));
+    }
+    const size_t bruteCount = std::min<size_t>(count, 2000);
+    ParticleSoA bruteRun;
+    double brute = time_best_ms(3, [&] {
+        bruteRun = soa;
+        bruteRun.count = bruteCount;
+        particles_update(bruteRun, config, dt, instances.data(), &all);
+    });
+
+    std::printf("  %7zu particles over %5.0f m, %4zu candidates (%s): off %7.2f ns/p   on %7.2f ns/p   "
+                "every collider %9.2f ns/p\n",
+                count, 2.0f * spread, candidates, batched ? "batched" : "per-particle grid", off * 1e6 / count,
+                on * 1e6 / count, brute * 1e6 / bruteCount);
+}
+
+static void bench_particle_collision() {
+    // Town-like layout as in bench_colliders, plus a ground slab
+    const size_t boxes = 2000;
+    const float halfArea = 10.0f * std::sqrt(static_cast<float>(boxes));
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    tCollidables colliders;
+    colliders.aabbs.push_back(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f)),
+                                         glm::vec3(halfArea, 1.0f, halfArea)));
+    for (size_t i = 0; i < boxes; i++) {
+        glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(unit(gen) * halfArea, 2.0f, unit(gen) * halfArea));
+        m = glm::rotate(m, unit(gen) * 3.14159f, glm::vec3(0, 1, 0));
+        m = glm::scale(m, glm::vec3(1.0f + unit(gen) * 0.5f, 2.0f, 1.0f + unit(gen) * 0.5f));
+        colliders.aabbs.push_back(m);
+    }
+    ColliderStore store;
+    store.sync(colliders);
+
+    std::cout << "particle collision: one 60 Hz bounce update, " << store.size() << " colliders" << std::endl;
+    for (size_t count : {size_t(10000), size_t(100000)}) {
+        bench_particle_collision_case(store, glm::vec3(0.0f), 3.0f, count);
+        bench_particle_collision_case(store, glm::vec3(0.0f), 100.0f, count);
+    }
+}
+
+// === Distance fields ===
+// Coverage of a shape, 4x4 supersampled like a FreeType bitmap, turned into
+// a field. Accuracy is checked by `--test sdf`.
+static void bench_sdf_case(const char* name, int size, const std::function<float(float, float)>& distance) {
+    const int downsample = 4, spread = 4;
+    std::vector<unsigned char> coverage(size * size);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            int hits = 0;
+            for (int sy = 0; sy < 4; sy++) {
+                for (int sx = 0; sx < 4; sx++) hits += distance(x + (sx + 0.5f) / 4.0f, y + (sy + 0.5f) / 4.0f) > 0.0f;
+            }
+            coverage[y * size + x] = static_cast<unsigned char>(hits * 255 / 16);
+        }
+    }
+
+    DistanceField field;
+    double ms = time_best_ms(20, [&]() { build_distance_field(coverage.data(), size, size, size, downsample, spread, field); });
+    printf("  %-8s %4d px -> %3dx%-3d field  %7.3f ms\n", name, size, field.width, field.height, ms);
+}
+
+static void bench_sdf() {
+    std::cout << "sdf: glyph-sized shapes at 4x, spread 4" << std::endl;
+    bench_sdf_case("circle", 128, [](float x, float y) { return 50.0f - std::hypot(x - 64.0f, y - 64.0f); });
+    bench_sdf_case("square", 128, [](float x, float y) {
+        float dx = std::abs(x - 64.0f) - 40.0f, dy = std::abs(y - 64.0f) - 40.0f;
+        float outside = std::hypot(std::max(dx, 0.0f), std::max(dy, 0.0f));
+        return -(outside + std::min(std::max(dx, dy), 0.0f));
+    });
+    bench_sdf_case("ring", 128, [](float x, float y) {
+        return 8.0f - std::abs(std::hypot(x - 64.0f, y - 64.0f) - 40.0f);
+    });
+}
+
+struct BenchEntry {
+    const char* name;
+    void (*fn)();
+};
+
+static const BenchEntry benchmarks[] = {
+    {"cull", bench_cull},
+    {"aabb", bench_aabb},
+    {"colliders", bench_colliders},
+    {"narrowphase", bench_narrowphase},
+    {"heightfield", bench_heightfield},
+    {"jobs", bench_jobs},
+    {"particles", bench_particles},
+    {"spawn", bench_spawn},
+    {"sort", bench_sort},
+    {"particle_collision", bench_particle_collision},
+    {"sdf", bench_sdf},
+};
+
+int run_benchmark(const std::string& name) {
+    bool found = false;
+    for (const auto& bench : benchmarks) {
+        if (name == "all" || name == bench.name) {
+            bench.fn();
+            found = true;
+        }
+    }
+
+    if (!found) {
+        std::cerr << "Unknown benchmark: " << name << "\nAvailable:";
+        for (const auto& bench : benchmarks) {
+            std::cerr << " " << bench.name;
+        }
+        std::cerr << " all" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <string>
+
+// Headless benchmarks, run with `./bin --bench <name>` (or `all`).
+// None of them create a window or touch GL, so they also run on build
+// machines without a GPU.
+int run_benchmark(const std::string& name);
@@ -0,0 +1,55 @@
+#include "bounds.hpp"
+#include "simd.hpp"
+#include <cfloat>
+
+void update_world_bounds(const glm::mat4* transforms, const AABB* local,
+                         size_t begin, size_t end, BoundsSoA& out) {
+    using namespace simd;
+    size_t i = begin;
+
+    // Four entities per iteration: transposing the same column of four
+    // matrices gives one register per matrix element across the entities.
+    for (; i + 4 <= end; i += 4) {
+        f32x4 m[4][3];
+        for (int col = 0; col < 4; col++) {
+            f32x4 c0 = load(&transforms[i + 0][col][0]);
+            f32x4 c1 = load(&transforms[i + 1][col][0]);
+            f32x4 c2 = load(&transforms[i + 2][col][0]);
+            f32x4 c3 = load(&transforms[i + 3][col][0]);
+            transpose4(c0, c1, c2, c3);
+            m[col][0] = c0; // x component of column col, one lane per entity
+            m[col][1] = c1;
+            m[col][2] = c2;
+        }
+
+        const AABB& a = local[i + 0];
+        const AABB& b = local[i + 1];
+        const AABB& c = local[i + 2];
+        const AABB& d = local[i + 3];
+        f32x4 half = set1(0.5f);
+        f32x4 loX = set(a.min.x, b.min.x, c.min.x, d.min.x);
+        f32x4 hiX = set(a.max.x, b.max.x, c.max.x, d.max.x);
+        // Empty boxes (min > max) would come out as inf / NaN, which every
+        // frustum plane test passes; keep them empty like AABB::transform
+        f32x4 empty = cmplt(hiX, loX);
+        f32x4 cx = (loX + hiX) * half;
+        f32x4 cy = (set(a.min.y, b.min.y, c.min.y, d.min.y) + set(a.max.y, b.max.y, c.max.y, d.max.y)) * half;
+        f32x4 cz = (set(a.min.z, b.min.z, c.min.z, d.min.z) + set(a.max.z, b.max.z, c.max.z, d.max.z)) * half;
+        f32x4 ex = (hiX - loX) * half;
+        f32x4 ey = (set(a.max.y, b.max.y, c.max.y, d.max.y) - set(a.min.y, b.min.y, c.min.y, d.min.y)) * half;
+        f32x4 ez = (set(a.max.z, b.max.z, c.max.z, d.max.z) - set(a.min.z, b.min.z, c.min.z, d.min.z)) * half;
+
+        float* minOut[3] = {out.minX.data(), out.minY.data(), out.minZ.data()};
+        float* maxOut[3] = {out.maxX.data(), out.maxY.data(), out.maxZ.data()};
+        for (int row = 0; row < 3; row++) {
+            f32x4 center = madd(m[0][row], cx, madd(m[1][row], cy, madd(m[2][row], cz, m[3][row])));
+            f32x4 extent = madd(abs(m[0][row]), ex, madd(abs(m[1][row]), ey, abs(m[2][row]) * ez));
+            store(minOut[row] + i, select(empty, set1(FLT_MAX), center - extent));
+            store(maxOut[row] + i, select(empty, set1(-FLT_MAX), center + extent));
+        }
+    }
+
+    for (; i < end; i++) {
+        out.set(i, local[i].transform(transforms[i]));
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "model.hpp"
+#include <cstddef>
+#include <vector>
+
+// World-space bounds stored structure-of-arrays so the transform and cull
+// kernels can work on four boxes per instruction.
+struct BoundsSoA {
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    size_t size() const { return minX.size(); }
+
+    void resize(size_t count) {
+        minX.resize(count); minY.resize(count); minZ.resize(count);
+        maxX.resize(count); maxY.resize(count); maxZ.resize(count);
+    }
+
+    AABB get(size_t i) const {
+        return AABB(glm::vec3(minX[i], minY[i], minZ[i]), glm::vec3(maxX[i], maxY[i], maxZ[i]));
+    }
+
+    void set(size_t i, const AABB& aabb) {
+        minX[i] = aabb.min.x; minY[i] = aabb.min.y; minZ[i] = aabb.min.z;
+        maxX[i] = aabb.max.x; maxY[i] = aabb.max.y; maxZ[i] = aabb.max.z;
+    }
+};
+
+// out[i] = local[i] transformed by transforms[i] for i in [begin, end), using
+// Arvo's absolute-matrix extents. out must already be sized. Matrices are
+// assumed affine, which holds for every model and collider transform.
+void update_world_bounds(const glm::mat4* transforms, const AABB* local,
+                         size_t begin, size_t end, BoundsSoA& out);
@@ -84,11 +84,11 @@ public:
     {
         glm::mat4 clipMatrix = projection * view;
 
-        // Extract matrix elements (GLM is column-major)
-        float m00 = clipMatrix[0][0], m01 = clipMatrix[1][0], m02 = clipMatrix[2][0], m03 = clipMatrix[3][0];
-        float m10 = clipMatrix[0][1], m11 = clipMatrix[1][1], m12 = clipMatrix[2][1], m13 = clipMatrix[3][1];
-        float m20 = clipMatrix[0][2], m21 = clipMatrix[1][2], m22 = clipMatrix[2][2], m23 = clipMatrix[3][2];
-        float m30 = clipMatrix[0][3], m31 = clipMatrix[1][3], m32 = clipMatrix[2][3], m33 = clipMatrix[3][3];
+        // Extract matrix elements (GLM is column-major, mCR = column C, row R)
+        float m00 = clipMatrix[0][0], m01 = clipMatrix[0][1], m02 = clipMatrix[0][2], m03 = clipMatrix[0][3];
+        float m10 = clipMatrix[1][0], m11 = clipMatrix[1][1], m12 = clipMatrix[1][2], m13 = clipMatrix[1][3];
+        float m20 = clipMatrix[2][0], m21 = clipMatrix[2][1], m22 = clipMatrix[2][2], m23 = clipMatrix[2][3];
+        float m30 = clipMatrix[3][0], m31 = clipMatrix[3][1], m32 = clipMatrix[3][2], m33 = clipMatrix[3][3];
 
         // Extract frustum planes (normals point inward)
         // Left plane: w + x >= 0
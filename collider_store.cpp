@@ -0,0 +1,120 @@
+#include "collider_store.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Colliders covering more cells than this go to the always-tested list
+static constexpr int MAX_CELLS_PER_COLLIDER = 64;
+
+glm::ivec3 ColliderStore::cellOf(const glm::vec3& p) const {
+    return glm::ivec3(glm::floor(p / cellSize));
+}
+
+uint32_t ColliderStore::slotOf(const glm::ivec3& cell) const {
+    uint32_t h = static_cast<uint32_t>(cell.x) * 73856093u ^
+                 static_cast<uint32_t>(cell.y) * 19349663u ^
+                 static_cast<uint32_t>(cell.z) * 83492791u;
+    return h & slotMask;
+}
+
+void ColliderStore::sync(const tCollidables& colliders) {
+    if (colliders.version != builtVersion) {
+        rebuild(colliders.aabbs, colliders.version);
+    }
+}
+
+void ColliderStore::rebuild(const std::vector<glm::mat4>& newTransforms, uint32_t version) {
+    builtVersion = version;
+    transforms = newTransforms;
+
+    const AABB unit(glm::vec3(-UNIT_HALF_EXTENT), glm::vec3(UNIT_HALF_EXTENT));
+    bounds.resize(transforms.size());
+    obbs.resize(transforms.size());
+    float extentSum = 0.0f;
+    for (size_t i = 0; i < transforms.size(); i++) {
+        bounds[i] = unit.transform(transforms[i]);
+        obbs[i] = OBB::fromTransform(transforms[i], UNIT_HALF_EXTENT);
+        glm::vec3 size = bounds[i].getSize();
+        extentSum += std::max(std::max(size.x, size.y), size.z);
+    }
+
+    // Cells about twice the average collider size keep most colliders in
+    // a handful of cells and most queries to a handful of cells too
+    if (!bounds.empty()) {
+        cellSize = std::max(0.5f, 2.0f * extentSum / bounds.size());
+    }
+
+    size_t slots = 16;
+    while (slots < transforms.size() * 2) slots <<= 1;
+    slotMask = static_cast<uint32_t>(slots - 1);
+
+    // Counting pass, then fill pass, into one flat item array
+    cellStart.assign(slots + 1, 0);
+    large.clear();
+    auto forEachCell = [&](const AABB& box, auto&& fn) {
+        glm::ivec3 lo = cellOf(box.min);
+        glm::ivec3 hi = cellOf(box.max);
+        for (int x = lo.x; x <= hi.x; x++)
+            for (int y = lo.y; y <= hi.y; y++)
+                for (int z = lo.z; z <= hi.z; z++)
+                    fn(slotOf(glm::ivec3(x, y, z)));
+    };
+    auto cellCount = [&](const AABB& box) {
+        glm::ivec3 span = cellOf(box.max) - cellOf(box.min) + 1;
+        return static_cast<long long>(span.x) * span.y * span.z;
+    };
+
+    for (uint32_t i = 0; i < bounds.size(); i++) {
+        if (cellCount(bounds[i]) > MAX_CELLS_PER_COLLIDER) {
+            large.push_back(i);
+            continue;
+        }
+        forEachCell(bounds[i], [&](uint32_t slot) { cellStart[slot + 1]++; });
+    }
+    for (size_t s = 0; s < slots; s++) {
+        cellStart[s + 1] += cellStart[s];
+    }
+
+    cellItems.resize(cellStart[slots]);
+    std::vector<uint32_t> cursor(cellStart.begin(), cellStart.end() - 1);
+    for (uint32_t i = 0; i < bounds.size(); i++) {
+        if (cellCount(bounds[i]) > MAX_CELLS_PER_COLLIDER) continue;
+        forEachCell(bounds[i], [&](uint32_t slot) { cellItems[cursor[slot]++] = i; });
+    }
+
+    queryStamp.assign(bounds.size(), 0);
+    currentStamp = 0;
+}
+
+void ColliderStore::query(const AABB& region, std::vector<uint32_t>& out) {
+    if (bounds.empty()) return;
+
+    if (++currentStamp == 0) {
+        std::fill(queryStamp.begin(), queryStamp.end(), 0);
+        currentStamp = 1;
+    }
+
+    auto consider = [&](uint32_t index) {
+        if (queryStamp[index] == currentStamp) return;
+        queryStamp[index] = currentStamp;
+        if (bounds[index].intersects(region)) {
+            out.push_back(index);
+        }
+    };
+
+    for (uint32_t index : large) {
+        consider(index);
+    }
+
+    glm::ivec3 lo = cellOf(region.min);
+    glm::ivec3 hi = cellOf(region.max);
+    for (int x = lo.x; x <= hi.x; x++) {
+        for (int y = lo.y; y <= hi.y; y++) {
+            for (int z = lo.z; z <= hi.z; z++) {
+                uint32_t slot = slotOf(glm::ivec3(x, y, z));
+                for (uint32_t k = cellStart[slot]; k < cellStart[slot + 1]; k++) {
+                    consider(cellItems[k]);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "model.hpp"
+#include "narrowphase.hpp"
+#include <cstdint>
+#include <vector>
+
+// World-space view of tCollidables, rebuilt only when the collider set's
+// version changes. Bounds are indexed in a hashed uniform grid stored as
+// flat arrays (cell start offsets + item list), so a query only touches
+// the colliders around it however many there are in the scene.
+class ColliderStore {
+public:
+    // Half extent of the box every collider matrix is applied to
+    static constexpr float UNIT_HALF_EXTENT = 1.0f;
+
+    // Rebuilds if colliders.version differs from the cached one
+    void sync(const tCollidables& colliders);
+    void rebuild(const std::vector<glm::mat4>& transforms, uint32_t version);
+
+    // Appends indices of colliders whose bounds overlap region; each index
+    // appears once per call
+    void query(const AABB& region, std::vector<uint32_t>& out);
+
+    size_t size() const { return bounds.size(); }
+    const AABB& getBounds(uint32_t index) const { return bounds[index]; }
+    const glm::mat4& getTransform(uint32_t index) const { return transforms[index]; }
+    const OBB& getOBB(uint32_t index) const { return obbs[index]; }
+    float getCellSize() const { return cellSize; }
+
+private:
+    glm::ivec3 cellOf(const glm::vec3& p) const;
+    uint32_t slotOf(const glm::ivec3& cell) const;
+
+    std::vector<glm::mat4> transforms;
+    std::vector<AABB> bounds;
+    std::vector<OBB> obbs;
+
+    // Colliders spanning too many cells live outside the grid and are
+    // returned by every query
+    std::vector<uint32_t> large;
+
+    float cellSize = 4.0f;
+    uint32_t slotMask = 0;
+    std::vector<uint32_t> cellStart; // slotMask + 2 entries, CSR offsets
+    std::vector<uint32_t> cellItems;
+
+    // Per-collider stamp used to de-duplicate query results
+    std::vector<uint32_t> queryStamp;
+    uint32_t currentStamp = 0;
+
+    uint32_t builtVersion = UINT32_MAX;
+};
@@ -1,8 +1,101 @@
 #include "collision_system.hpp"
 #include "camera.hpp"
+#include "collider_store.hpp"
 #include "model.hpp"
+#include "narrowphase.hpp"
+
+// Slide iterations per move; three planes are enough to resolve a corner
+static constexpr int SLIDE_ITERATIONS = 4;
+static constexpr int DEPENETRATION_ITERATIONS = 4;
+// Distance backed off from a hit so the next sweep starts outside
+static constexpr float CONTACT_OFFSET = 2e-3f;
 
 glm::vec3 lastOkayPosition;
+static ColliderStore store;
+static PlayerShape player;
+static std::vector<uint32_t> nearby;
+
+static Capsule player_capsule(const PlayerShape &shape, const glm::vec3 &eye) {
+  return {eye - glm::vec3(0.0f, shape.height, 0.0f), eye, shape.radius};
+}
+
+// Earliest hit of the capsule moving by delta against the candidates
+static bool sweep_nearby(const Capsule &capsule, const glm::vec3 &delta,
+                         ColliderStore &colliders, SweepHit &earliest) {
+  bool hitAny = false;
+  earliest.t = 1.0f;
+  for (uint32_t index : nearby) {
+    SweepHit hit;
+    if (sweep_capsule_obb(capsule, delta, colliders.getOBB(index), hit) &&
+        hit.t <= earliest.t) {
+      earliest = hit;
+      hitAny = true;
+    }
+  }
+  return hitAny;
+}
+
+glm::vec3 collision_move_and_slide(ColliderStore &colliders, const PlayerShape &shape,
+                                   const glm::vec3 &from, const glm::vec3 &delta) {
+  // One broadphase query covers the whole swept volume
+  Capsule start = player_capsule(shape, from);
+  AABB region(glm::min(start.a, start.b), glm::max(start.a, start.b));
+  region.expand(AABB(region.min + delta, region.max + delta));
+  region = AABB(region.min - glm::vec3(shape.radius + CONTACT_OFFSET),
+                region.max + glm::vec3(shape.radius + CONTACT_OFFSET));
+  nearby.clear();
+  colliders.query(region, nearby);
+
+  glm::vec3 position = from;
+  glm::vec3 remaining = delta;
+  glm::vec3 firstNormal(0.0f);
+
+  for (int i = 0; i < SLIDE_ITERATIONS; i++) {
+    float length = glm::length(remaining);
+    if (length < 1e-6f) break;
+
+    SweepHit hit;
+    if (!sweep_nearby(player_capsule(shape, position), remaining, colliders, hit)) {
+      position += remaining;
+      break;
+    }
+
+    // Advance to just before the contact, then slide the rest along it
+    float travel = std::max(0.0f, hit.t * length - CONTACT_OFFSET);
+    position += remaining * (travel / length);
+    remaining *= 1.0f - hit.t;
+    remaining -= hit.normal * glm::dot(remaining, hit.normal);
+
+    // Second plane: follow the crease instead of bouncing between them
+    if (i == 0) {
+      firstNormal = hit.normal;
+    } else if (glm::dot(firstNormal, hit.normal) < 0.999f) {
+      glm::vec3 crease = glm::cross(firstNormal, hit.normal);
+      float creaseLength = glm::length(crease);
+      if (creaseLength > 1e-4f) {
+        crease /= creaseLength;
+        remaining = crease * glm::dot(remaining, crease);
+      }
+    }
+  }
+
+  // Push out of anything still overlapping, e.g. a collider that was moved
+  // onto the player in the editor
+  for (int i = 0; i < DEPENETRATION_ITERATIONS; i++) {
+    bool resolved = true;
+    for (uint32_t index : nearby) {
+      Contact contact;
+      if (capsule_obb_contact(player_capsule(shape, position), colliders.getOBB(index), contact)) {
+        position += contact.normal * (contact.depth + CONTACT_OFFSET);
+        resolved = false;
+      }
+    }
+    if (resolved) break;
+  }
+
+  return position;
+}
+
 void collision_system_init() {
   Camera &cam = entt::locator<Camera>::value();
   lastOkayPosition = cam.Position;
@@ -11,16 +104,13 @@ void collision_system_init() {
 void collision_system_update(float dt) {
 
   Camera &cam = entt::locator<Camera>::value();
-  auto colliders = entt::locator<tCollidables>::value();
-  auto base = AABB(glm::vec3(-1, -1, -1), glm::vec3(1,1,1));
-
-  for (auto &box : colliders.aabbs) {
-    auto test = base.transform(box);
-    if (test.contains(cam.Position)) {
-      cam.Position = lastOkayPosition;
-      return;
-    }
-  }
+  const tCollidables &colliders = entt::locator<tCollidables>::value();
+  store.sync(colliders);
+
+  // The camera has already been moved by input this frame; sweep the player
+  // from where it was along that motion instead of testing the end point
+  glm::vec3 delta = cam.Position - lastOkayPosition;
+  cam.Position = collision_move_and_slide(store, player, lastOkayPosition, delta);
 
   lastOkayPosition = cam.Position;
 }
@@ -2,11 +2,22 @@
 #include "model.hpp"
 #include <vector>
 
+class ColliderStore;
 
-
+// Player collision volume: a vertical capsule hanging below the camera
+struct PlayerShape {
+    float radius = 0.25f;
+    float height = 0.75f; // distance from the eye down to the lower sphere centre
+};
 
 void collision_system_init();
 void collision_system_update(float dt);
 
+// Moves a capsule-shaped player from `from` by `delta` through the
+// colliders in store, sliding along whatever it hits. Swept, so the
+// result does not depend on how large the step is.
+glm::vec3 collision_move_and_slide(ColliderStore& store, const PlayerShape& shape,
+                                   const glm::vec3& from, const glm::vec3& delta);
+
 
 //
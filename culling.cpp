@@ -0,0 +1,109 @@
+#include "culling.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <cstring>
+
+// Below this many boxes per chunk the hand-off costs more than the tests
+static constexpr size_t CULL_MIN_CHUNK = 4096;
+
+void cull_range(const AABB* bounds, size_t begin, size_t end, const Frustum& frustum,
+                std::vector<uint32_t>& out) {
+    for (size_t i = begin; i < end; i++) {
+        if (aabb_in_frustum(bounds[i], frustum)) {
+            out.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+void cull_range_soa(const BoundsSoA& bounds, size_t begin, size_t end, const Frustum& frustum,
+                    std::vector<uint32_t>& out) {
+    using namespace simd;
+
+    // The positive vertex only depends on the plane, so pick its source
+    // arrays once per plane instead of per box
+    const float* px[6];
+    const float* py[6];
+    const float* pz[6];
+    f32x4 nx[6], ny[6], nz[6], nw[6];
+    for (int p = 0; p < 6; p++) {
+        const glm::vec4& plane = frustum.planes[p];
+        px[p] = plane.x >= 0.0f ? bounds.maxX.data() : bounds.minX.data();
+        py[p] = plane.y >= 0.0f ? bounds.maxY.data() : bounds.minY.data();
+        pz[p] = plane.z >= 0.0f ? bounds.maxZ.data() : bounds.minZ.data();
+        nx[p] = set1(plane.x);
+        ny[p] = set1(plane.y);
+        nz[p] = set1(plane.z);
+        nw[p] = set1(plane.w);
+    }
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        f32x4 outside = zero();
+        for (int p = 0; p < 6; p++) {
+            f32x4 d = madd(load(px[p] + i), nx[p], madd(load(py[p] + i), ny[p], madd(load(pz[p] + i), nz[p], nw[p])));
+            outside = bit_or(outside, cmplt(d, zero()));
+        }
+
+        int visibleMask = ~movemask(outside) & 0xf;
+        while (visibleMask) {
+            int lane = __builtin_ctz(visibleMask);
+            out.push_back(static_cast<uint32_t>(i + lane));
+            visibleMask &= visibleMask - 1;
+        }
+    }
+
+    for (; i < end; i++) {
+        if (aabb_in_frustum(bounds.get(i), frustum)) {
+            out.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+void cull_scratch_reset(JobSystem& jobs, CullScratch& scratch) {
+    scratch.perSlot.resize(jobs.size());
+    scratch.offsets.resize(jobs.size() + 1);
+    for (auto& list : scratch.perSlot) {
+        list.clear();
+    }
+}
+
+void cull_scratch_merge(JobSystem& jobs, CullScratch& scratch, std::vector<uint32_t>& out) {
+    size_t slots = scratch.perSlot.size();
+    scratch.offsets[0] = 0;
+    for (size_t s = 0; s < slots; s++) {
+        scratch.offsets[s + 1] = scratch.offsets[s] + scratch.perSlot[s].size();
+    }
+    out.resize(scratch.offsets[slots]);
+
+    jobs.parallel_for(slots, 1, [&](size_t begin, size_t end, unsigned int) {
+        for (size_t s = begin; s < end; s++) {
+            const auto& list = scratch.perSlot[s];
+            if (!list.empty()) {
+                std::memcpy(out.data() + scratch.offsets[s], list.data(),
+                            list.size() * sizeof(uint32_t));
+            }
+        }
+    });
+}
+
+void cull_parallel(JobSystem& jobs, const AABB* bounds, size_t count, const Frustum& frustum,
+                   CullScratch& scratch, std::vector<uint32_t>& visible) {
+    cull_scratch_reset(jobs, scratch);
+
+    jobs.parallel_for(count, CULL_MIN_CHUNK, [&](size_t begin, size_t end, unsigned int slot) {
+        cull_range(bounds, begin, end, frustum, scratch.perSlot[slot]);
+    });
+
+    cull_scratch_merge(jobs, scratch, visible);
+}
+
+void cull_parallel(JobSystem& jobs, const BoundsSoA& bounds, const Frustum& frustum,
+                   CullScratch& scratch, std::vector<uint32_t>& visible) {
+    cull_scratch_reset(jobs, scratch);
+
+    jobs.parallel_for(bounds.size(), CULL_MIN_CHUNK, [&](size_t begin, size_t end, unsigned int slot) {
+        cull_range_soa(bounds, begin, end, frustum, scratch.perSlot[slot]);
+    });
+
+    cull_scratch_merge(jobs, scratch, visible);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "bounds.hpp"
+#include "camera.hpp"
+#include "model.hpp"
+#include "job_system.hpp"
+#include <cstdint>
+#include <vector>
+
+// Conservative frustum test - true if the box is inside or straddles the frustum
+inline bool aabb_in_frustum(const AABB& aabb, const Frustum& frustum) {
+    for (int i = 0; i < 6; i++) {
+        const glm::vec4& plane = frustum.planes[i];
+
+        // Corner furthest along the plane normal (positive vertex)
+        glm::vec3 p(plane.x >= 0.0f ? aabb.max.x : aabb.min.x,
+                    plane.y >= 0.0f ? aabb.max.y : aabb.min.y,
+                    plane.z >= 0.0f ? aabb.max.z : aabb.min.z);
+
+        if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Per-thread visible lists, kept between frames so culling does not allocate
+struct CullScratch {
+    std::vector<std::vector<uint32_t>> perSlot;
+    std::vector<size_t> offsets;
+};
+
+// Clears and sizes the per-thread lists for a pass over the job system
+void cull_scratch_reset(JobSystem& jobs, CullScratch& scratch);
+
+// Concatenates the per-thread lists into out without locks: an exclusive
+// prefix sum over the list sizes gives every thread a disjoint window.
+void cull_scratch_merge(JobSystem& jobs, CullScratch& scratch, std::vector<uint32_t>& out);
+
+// Appends the indices in [begin, end) whose bounds pass the frustum test
+void cull_range(const AABB* bounds, size_t begin, size_t end, const Frustum& frustum,
+                std::vector<uint32_t>& out);
+
+// SoA variant of cull_range, testing four boxes per plane at a time
+void cull_range_soa(const BoundsSoA& bounds, size_t begin, size_t end, const Frustum& frustum,
+                    std::vector<uint32_t>& out);
+
+// Culls bounds[0..count) across the job system, every thread writing to its own
+// list. Order of visible is by thread, not by index.
+void cull_parallel(JobSystem& jobs, const AABB* bounds, size_t count, const Frustum& frustum,
+                   CullScratch& scratch, std::vector<uint32_t>& visible);
+
+void cull_parallel(JobSystem& jobs, const BoundsSoA& bounds, const Frustum& frustum,
+                   CullScratch& scratch, std::vector<uint32_t>& visible);
@@ -0,0 +1,40 @@
+#include "frame_uniforms.hpp"
+#include "camera.hpp"
+#include "model.hpp"
+#include "shader.hpp"
+#include <entt/entt.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+static FrameUniforms frame;
+static unsigned int frameBuffer = 0;
+
+void frame_uniforms_init() {
+    glGenBuffers(1, &frameBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_STREAM_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, frameBuffer);
+    Shader::BindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
+}
+
+void frame_uniforms_update(float dt) {
+    Camera &camera = entt::locator<Camera>::value();
+    glm::vec2 window = entt::locator<Meta>::value().WindowDimensions;
+
+    frame.view = camera.GetViewMatrix();
+    frame.projection = glm::perspective(glm::radians(camera.Zoom), window.x / window.y, FRAME_NEAR_PLANE,
+                                        FRAME_FAR_PLANE);
+    frame.viewProjection = frame.projection * frame.view;
+    frame.cameraPosition = glm::vec4(camera.Position, 1.0f);
+    frame.viewport = glm::vec4(window.x, window.y, 1.0f / window.x, 1.0f / window.y);
+    frame.time += dt;
+    frame.deltaTime = dt;
+
+    // A fresh store each frame, so the upload never waits on draws still
+    // reading last frame's
+    glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), &frame, GL_STREAM_DRAW);
+}
+
+const FrameUniforms &frame_uniforms() {
+    return frame;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "mygl.h"
+#include <glm/glm.hpp>
+
+// Values every shader reads from its FrameUniforms block, written once a
+// frame into one uniform buffer. Laid out as std140, which the block
+// declared in each shader has to match.
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 cameraPosition; // w is 1
+    glm::vec4 viewport;       // width, height, 1 / width, 1 / height
+    float time;               // seconds of frames drawn so far
+    float deltaTime;
+    float _pad[2];
+};
+static_assert(sizeof(FrameUniforms) == 240, "FrameUniforms has to match the std140 block");
+
+// The buffer stays bound here, and every program's FrameUniforms block is
+// pointed here as it is built
+constexpr unsigned int FRAME_UNIFORMS_BINDING = 0;
+constexpr float FRAME_NEAR_PLANE = 0.1f;
+constexpr float FRAME_FAR_PLANE = 1000.0f;
+
+// Creates the buffer; before any program is built
+void frame_uniforms_init();
+// Works this frame's values out from the camera and window and uploads
+// them, before anything draws
+void frame_uniforms_update(float dt);
+const FrameUniforms &frame_uniforms();
@@ -1,16 +1,22 @@
 #include "game.hpp"
+#include "frame_uniforms.hpp"
+#include "Input.hpp"
 #include "text_renderer.hpp"
 #include "camera.hpp"
 #include "collision_system.hpp"
 #include "ground_system.hpp"
+#include "heightfield.hpp"
 #include "light_system.hpp"
 #include "model.hpp"
 #include "model_loader.hpp"
 #include "model_setup.hpp"
+#include "particle_manager.hpp"
 #include "render_system.hpp"
 #include "resource_ids.hpp"
 #include "shader.hpp"
 #include "static_system.hpp"
+#include "job_system.hpp"
+#include "system_scheduler.hpp"
 #include <cmath>
 #include <entt/entt.hpp>
 #include <iostream>
@@ -20,6 +26,88 @@
 
 entt::entity e;
 AnimatedModel aModel;
+
+// Simulated state at the end of the last two ticks. Rendering blends
+// between them, so motion stays smooth at any frame rate.
+struct SimSnapshot {
+  glm::vec3 cameraPosition;
+};
+
+static SimSnapshot previousState;
+static SimSnapshot currentState;
+static float tickLength = 0.0f;
+static GLFWwindow *gameWindow = nullptr;
+
+static SimSnapshot capture_state() {
+  return {entt::locator<Camera>::value().Position};
+}
+
+// Systems declare what they read and write; the schedulers order the ones
+// that conflict and overlap the rest. Everything drawing goes on the main
+// thread, which owns the GL context.
+static SystemScheduler tickSchedule("tick");
+static SystemScheduler renderSchedule("render");
+static float renderAlpha = 0.0f;
+
+static void register_systems() {
+  tickSchedule.add({.name = "ground",
+                    .fn = ground_system_update,
+                    .reads = access<Heightfield>(),
+                    .writes = access<Camera>()});
+  tickSchedule.add({.name = "animation",
+                    .fn = [](float dt) { aModel.update(dt); },
+                    .writes = access<AnimatedModel>()});
+  tickSchedule.add({.name = "collision",
+                    .fn = collision_system_update,
+                    .reads = access<tCollidables>(),
+                    .writes = access<Camera>()});
+  tickSchedule.add({.name = "particles",
+                    .fn = [](float dt) {
+                      // Frustum from the last render picks each emitter's detail
+                      Camera &camera = entt::locator<Camera>::value();
+                      ParticleManager &particles = entt::locator<ParticleManager>::value();
+                      particles.setView(camera.Position, camera.ViewFrustum);
+                      if (entt::locator<tCollidables>::has_value()) {
+                        particles.setColliders(entt::locator<tCollidables>::value());
+                      }
+                      particles.update(dt);
+                    },
+                    .reads = access<Camera, tCollidables>(),
+                    .writes = access<ParticleManager>()});
+
+  renderSchedule.add({.name = "scene",
+                      .fn = [](float) { render_system_update(); },
+                      .reads = access<Model, Shaders, Meta>(),
+                      .writes = access<Camera>(),
+                      .mainThread = true});
+  renderSchedule.add({.name = "animated model",
+                      .fn = [](float) {
+                        aModel.render(-(1.0f - renderAlpha) * tickLength);
+                      },
+                      .reads = access<AnimatedModel>(),
+                      .mainThread = true});
+  renderSchedule.add({.name = "particles",
+                      .fn = [](float) {
+                        // Back from the last tick to the interpolated view's time
+                        entt::locator<ParticleManager>::value().render(frame_uniforms().view,
+                                                                       -(1.0f - renderAlpha) * tickLength);
+                      },
+                      .writes = access<ParticleManager>(),
+                      .mainThread = true});
+  renderSchedule.add({.name = "static editor",
+                      .fn = static_system_update,
+                      .reads = access<Camera, Meta>(),
+                      .writes = access<Model, tCollidables, Heightfield>(),
+                      .mainThread = true});
+
+  for (auto *schedule : {&tickSchedule, &renderSchedule}) {
+    std::cout << "Schedule " << schedule->getName() << ":" << std::endl;
+    for (const auto &line : schedule->describe()) {
+      std::cout << "  " << line << std::endl;
+    }
+  }
+}
+
 void game_init(GLFWwindow *window) {
     // Model model = load_model("resources/models/buster_drone/scene.gltf");
     // // model.aabb =
@@ -27,49 +115,89 @@ void game_init(GLFWwindow *window) {
     // e = ecs.create() ;
     // ecs.emplace<Model>(e, model);
     // uploadData(&model, glm::mat4(1.0f));//model.aabb.getFromUnitCubeTransform());
+    gameWindow = window;
+    // Before any program is built, so each one gets the block binding
+    frame_uniforms_init();
     Shaders shaders;
   shaders.MAIN = Shader::Create(resources::path(resources::Shaders_vertex),
                                 resources::path(resources::Shaders_fragment));
 
-  // shaders.TEXT= Shader::Create(resources::path(resources::Shaders_text_vertex),
-  //                                 resources::path(resources::Shaders_text_fragment));
+  shaders.TEXT = Shader::Create(resources::path(resources::Shaders_text_vertex),
+                                resources::path(resources::Shaders_text_fragment));
 
 
 
   entt::locator<Shaders>::emplace(shaders);
+  entt::locator<JobSystem>::emplace();
+  entt::locator<ParticleManager>::emplace();
   auto win = entt::locator<Meta>::value().WindowDimensions;
 
 
 
   light_system_init();
-
-
-
+  text_init();
+  // Loads the level and provides the colliders and heightfield
+  static_system_init();
+  collision_system_init();
+  ground_system_init();
+  register_systems();
+
+  currentState = capture_state();
+  previousState = currentState;
+
+  const Shader::CacheStats &programs = Shader::GetCacheStats();
+  std::cout << "Shaders: " << programs.programs << " programs in " << programs.milliseconds << " ms, "
+            << programs.fromCache << " from the binary cache, " << programs.compiled << " compiled";
+  if (programs.rejected > 0)
+    std::cout << " (" << programs.rejected << " stale binaries dropped)";
+  std::cout << std::endl;
 }
 
-void game_update(float dt) {
+// Edited shaders are rebuilt between frames; while one fails to build
+// the old program keeps drawing and the title bar says so
+static void reload_shaders() {
+  if (!Shader::ReloadChanged())
+    return;
+  std::string errors = Shader::ReloadErrors();
+  if (errors.empty()) {
+    glfwSetWindowTitle(gameWindow, WINDOW_TITLE);
+    return;
+  }
+  std::string title = std::string(WINDOW_TITLE) + " - shader error: " + errors.substr(0, errors.find(':'));
+  glfwSetWindowTitle(gameWindow, title.c_str());
+}
 
-  // ground_system_update(dt);
-  aModel.update(dt);
+void game_tick(float dt) {
+  previousState = currentState;
+  tickLength = dt;
 
+  tickSchedule.run(entt::locator<JobSystem>::value(), dt);
 
-  // collision_system_update(dt);
-  render_system_update();
-  auto camera = entt::locator<Camera>::value();
-  Meta& meta = entt::locator<Meta>::value();
+  currentState = capture_state();
+}
 
-  glm::mat4 projection = glm::perspective(
-      glm::radians(camera.Zoom),
-      meta.WindowDimensions.x / meta.WindowDimensions.y,
-      0.1f, 100.0f
-  );
-  glm::mat4 view = camera.GetViewMatrix();
-  glm::mat4 vp = projection * view;
+void game_render(float alpha, float dt) {
+  JobSystem &jobs = entt::locator<JobSystem>::value();
+  // GL work queued by jobs during the ticks
+  jobs.run_main_jobs();
+  reload_shaders();
 
-  aModel.render(view, projection);
-  // static_system_update(dt);
+  // Draw from the blended position, then hand the simulated one back
+  Camera &simCamera = entt::locator<Camera>::value();
+  glm::vec3 simPosition = simCamera.Position;
+  simCamera.Position = glm::mix(previousState.cameraPosition, currentState.cameraPosition, alpha);
 
+  renderAlpha = alpha;
+  frame_uniforms_update(dt);
+  renderSchedule.run(jobs, dt);
 
+  // All the frame's UI text, over everything else in one draw
+  FlushText(entt::locator<Shaders>::value().TEXT);
+  text_end_frame();
 
+  simCamera.Position = simPosition;
 
+  if (Input::is_key_just_pressed(GLFW_KEY_F9)) {
+    export_timeline("timeline.json", {&tickSchedule, &renderSchedule});
+  }
 }
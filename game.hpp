@@ -1,5 +1,11 @@
 #pragma once
 #include "mygl.h"
 
+constexpr const char *WINDOW_TITLE = "3D OpenGL Renderer";
+
 void game_init(GLFWwindow*window);
-void game_update(float dt);
+// Advances the simulation by one fixed step
+void game_tick(float dt);
+// Draws the world alpha of the way from the previous tick to the latest
+// one; dt is the real time since the last frame
+void game_render(float alpha, float dt);
@@ -0,0 +1,397 @@
+#include "glyph_atlas.hpp"
+#include "sdf.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+// Size RenderText's scale is relative to: scale 1 draws 48 px text
+static constexpr int FONT_PIXEL_SIZE = 48;
+// Em size of the glyphs in the atlas. They are distance fields, so one
+// size serves text both smaller and well above it.
+static constexpr int SDF_GLYPH_SIZE = 32;
+// Glyphs are rasterized this many times larger than the field
+static constexpr int SDF_DOWNSAMPLE = 4;
+// Field texels from the outline to full inside or outside; limits how far
+// text can be scaled down before neighbouring edges blend
+static constexpr int SDF_SPREAD = 4;
+
+// Empty texels between glyphs so linear filtering never picks up a neighbour
+static constexpr int ATLAS_PADDING = 1;
+// Shelf heights are rounded up to this, so glyphs of similar height share
+static constexpr int SHELF_ROUNDING = 8;
+
+static const char GLYPH_CACHE_MAGIC[4] = {'G', 'L', 'Y', 'F'};
+static constexpr uint32_t GLYPH_CACHE_VERSION = 1;
+
+GlyphAtlas::~GlyphAtlas()
+{
+    if (face)
+        FT_Done_Face(face);
+    if (library)
+        FT_Done_FreeType(library);
+    if (atlasTexture)
+        glDeleteTextures(1, &atlasTexture);
+}
+
+void GlyphAtlas::init(const std::string& fontPath, const std::string& cachePath)
+{
+    this->fontPath = fontPath;
+    this->cachePath = cachePath;
+    std::fill(std::begin(asciiSlots), std::end(asciiSlots), -1);
+
+    std::error_code error;
+    fontBytes = std::filesystem::file_size(fontPath, error);
+    if (error)
+        fontBytes = 0;
+    loadCache();
+
+    // disable byte-alignment restriction
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    std::vector<unsigned char> empty(static_cast<size_t>(WIDTH) * HEIGHT, 0);
+    glGenTextures(1, &atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, WIDTH, HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, empty.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+const Character* GlyphAtlas::find(uint32_t codepoint, int* shelf)
+{
+    int slot = -1;
+    if (codepoint < 128)
+    {
+        slot = asciiSlots[codepoint];
+    }
+    else
+    {
+        auto it = otherSlots.find(codepoint);
+        if (it != otherSlots.end())
+            slot = it->second;
+    }
+
+    if (slot < 0)
+    {
+        const GlyphRecord* glyph = record(codepoint);
+        if (!glyph)
+            return nullptr;
+        slot = place(codepoint, *glyph);
+        if (slot < 0)
+        {
+            stats.failed++;
+            return nullptr;
+        }
+    }
+
+    if (slots[slot].shelf >= 0)
+        shelves[slots[slot].shelf].lastUsed = frame;
+    if (shelf)
+        *shelf = slots[slot].shelf;
+    return &slots[slot].character;
+}
+
+void GlyphAtlas::touch(const std::vector<int>& used)
+{
+    for (int shelf : used)
+        shelves[shelf].lastUsed = frame;
+}
+
+bool GlyphAtlas::evictedSince(const std::vector<int>& used, uint32_t since) const
+{
+    for (int shelf : used)
+    {
+        if (shelves[shelf].evictedAt > since)
+            return true;
+    }
+    return false;
+}
+
+const GlyphAtlasStats& GlyphAtlas::getStats()
+{
+    size_t area = 0;
+    stats.resident = 0;
+    for (const Shelf& shelf : shelves)
+    {
+        for (int slot : shelf.slots)
+            area += static_cast<size_t>(slots[slot].width) * slots[slot].height;
+        stats.resident += shelf.slots.size();
+    }
+    stats.known = records.size();
+    stats.occupancy = static_cast<float>(area) / (WIDTH * HEIGHT);
+    return stats;
+}
+
+const GlyphAtlas::GlyphRecord* GlyphAtlas::record(uint32_t codepoint)
+{
+    auto it = records.find(codepoint);
+    if (it != records.end())
+        return &it->second;
+
+    if (failed.count(codepoint))
+        return nullptr;
+    GlyphRecord glyph;
+    if (!rasterize(codepoint, glyph))
+    {
+        failed.insert(codepoint);
+        return nullptr;
+    }
+    stats.rasterized++;
+    appendToCache(codepoint, glyph);
+    return &records.emplace(codepoint, std::move(glyph)).first->second;
+}
+
+bool GlyphAtlas::openFont()
+{
+    if (face)
+        return true;
+    if (fontFailed)
+        return false;
+
+    // All functions return a value different than 0 whenever an error occurred
+    fontFailed = true;
+    if (FT_Init_FreeType(&library))
+    {
+        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+        library = nullptr;
+        return false;
+    }
+    if (FT_New_Face(library, fontPath.c_str(), 0, &face))
+    {
+        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+        face = nullptr;
+        return false;
+    }
+    // glyphs are rendered large and reduced to a distance field
+    FT_Set_Pixel_Sizes(face, 0, SDF_GLYPH_SIZE * SDF_DOWNSAMPLE);
+    fontFailed = false;
+    return true;
+}
+
+bool GlyphAtlas::rasterize(uint32_t codepoint, GlyphRecord& out)
+{
+    if (!openFont())
+        return false;
+    // Codepoints the font lacks come back as its missing-glyph box
+    if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER))
+    {
+        std::cout << "ERROR::FREETYTPE: Failed to load Glyph " << codepoint << std::endl;
+        return false;
+    }
+
+    const FT_Bitmap& bitmap = face->glyph->bitmap;
+    DistanceField field;
+    build_distance_field(bitmap.buffer, bitmap.width, bitmap.rows, bitmap.pitch, SDF_DOWNSAMPLE, SDF_SPREAD, field);
+
+    // Metrics in FONT_PIXEL_SIZE pixels, with the quad covering the field's padding
+    const float unitsPerTexel = static_cast<float>(FONT_PIXEL_SIZE) / SDF_GLYPH_SIZE;
+    float left = static_cast<float>(face->glyph->bitmap_left) / SDF_DOWNSAMPLE - field.padding;
+    float top = static_cast<float>(face->glyph->bitmap_top) / SDF_DOWNSAMPLE + field.padding;
+    out.size = glm::vec2(field.width * unitsPerTexel, field.height * unitsPerTexel);
+    out.bearing = glm::vec2(left * unitsPerTexel, top * unitsPerTexel);
+    out.advance = face->glyph->advance.x / 64.0f / SDF_DOWNSAMPLE * unitsPerTexel;
+    out.width = field.width;
+    out.height = field.height;
+    out.field = std::move(field.pixels);
+    return true;
+}
+
+int GlyphAtlas::place(uint32_t codepoint, const GlyphRecord& glyph)
+{
+    int shelf = -1;
+    int x = 0;
+    if (glyph.width > 0 && glyph.height > 0)
+    {
+        shelf = findShelf(glyph.width, glyph.height);
+        if (shelf < 0)
+            return -1;
+        Shelf& s = shelves[shelf];
+        x = s.penX;
+        s.penX += glyph.width + ATLAS_PADDING;
+
+        glBindTexture(GL_TEXTURE_2D, atlasTexture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, s.y, glyph.width, glyph.height, GL_RED, GL_UNSIGNED_BYTE,
+                        glyph.field.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    int slot;
+    if (!freeSlots.empty())
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<int>(slots.size());
+        slots.emplace_back();
+    }
+
+    float y = shelf >= 0 ? static_cast<float>(shelves[shelf].y) : 0.0f;
+    slots[slot] = {
+        codepoint,
+        shelf,
+        glyph.width,
+        glyph.height,
+        {glm::vec2(float(x) / WIDTH, y / HEIGHT),
+         glm::vec2(float(x + glyph.width) / WIDTH, (y + glyph.height) / HEIGHT),
+         glyph.size,
+         glyph.bearing,
+         glyph.advance}};
+    if (shelf >= 0)
+        shelves[shelf].slots.push_back(slot);
+
+    if (codepoint < 128)
+        asciiSlots[codepoint] = slot;
+    else
+        otherSlots[codepoint] = slot;
+    return slot;
+}
+
+int GlyphAtlas::findShelf(int width, int height)
+{
+    const int needWidth = width + ATLAS_PADDING;
+    const int needHeight = height + ATLAS_PADDING;
+    if (needWidth > WIDTH || needHeight > HEIGHT)
+        return -1;
+
+    // The shortest shelf with room
+    int best = -1;
+    for (int i = 0; i < static_cast<int>(shelves.size()); i++)
+    {
+        const Shelf& s = shelves[i];
+        if (s.height >= needHeight && s.penX + needWidth <= WIDTH && (best < 0 || s.height < shelves[best].height))
+            best = i;
+    }
+    if (best >= 0)
+        return best;
+
+    // A new one below the others
+    int shelfHeight = std::min((needHeight + SHELF_ROUNDING - 1) / SHELF_ROUNDING * SHELF_ROUNDING, HEIGHT);
+    if (nextShelfY + shelfHeight <= HEIGHT)
+    {
+        shelves.push_back({nextShelfY, shelfHeight, 0, frame, {}, 0});
+        nextShelfY += shelfHeight;
+        return static_cast<int>(shelves.size()) - 1;
+    }
+
+    // The least recently used shelf tall enough, if nothing on it was drawn this frame
+    int oldest = -1;
+    for (int i = 0; i < static_cast<int>(shelves.size()); i++)
+    {
+        const Shelf& s = shelves[i];
+        if (s.height < needHeight || s.lastUsed >= frame)
+            continue;
+        if (oldest < 0 || s.lastUsed < shelves[oldest].lastUsed ||
+            (s.lastUsed == shelves[oldest].lastUsed && s.height < shelves[oldest].height))
+            oldest = i;
+    }
+    if (oldest >= 0)
+        evictShelf(oldest);
+    return oldest;
+}
+
+void GlyphAtlas::evictShelf(int shelf)
+{
+    Shelf& s = shelves[shelf];
+    for (int slot : s.slots)
+    {
+        uint32_t codepoint = slots[slot].codepoint;
+        if (codepoint < 128)
+            asciiSlots[codepoint] = -1;
+        else
+            otherSlots.erase(codepoint);
+        freeSlots.push_back(slot);
+    }
+    stats.evictions += s.slots.size();
+    s.slots.clear();
+    s.penX = 0;
+    s.evictedAt = ++evictionGeneration;
+
+    // Clear the old glyphs so new, narrower ones don't filter against them
+    std::vector<unsigned char> empty(static_cast<size_t>(WIDTH) * s.height, 0);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, s.y, WIDTH, s.height, GL_RED, GL_UNSIGNED_BYTE, empty.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Cache file: header, then one record per glyph in the order they were
+// rasterized. A record cut short by a crash is dropped on the next load.
+void GlyphAtlas::loadCache()
+{
+    const int32_t params[4] = {FONT_PIXEL_SIZE, SDF_GLYPH_SIZE, SDF_DOWNSAMPLE, SDF_SPREAD};
+    bool valid = false;
+    std::streamoff validBytes = 0;
+    {
+        std::ifstream file(cachePath, std::ios::binary);
+        char magic[4];
+        uint32_t version = 0;
+        int32_t fileParams[4];
+        uint64_t fileFontBytes = 0;
+        file.read(magic, sizeof(magic));
+        file.read(reinterpret_cast<char*>(&version), sizeof(version));
+        file.read(reinterpret_cast<char*>(fileParams), sizeof(fileParams));
+        file.read(reinterpret_cast<char*>(&fileFontBytes), sizeof(fileFontBytes));
+        // Without the font there is nothing to check against, and nothing
+        // better to use than the cache
+        valid = file && std::memcmp(magic, GLYPH_CACHE_MAGIC, sizeof(magic)) == 0 && version == GLYPH_CACHE_VERSION &&
+                std::memcmp(params, fileParams, sizeof(params)) == 0 && (fontBytes == 0 || fileFontBytes == fontBytes);
+
+        while (valid)
+        {
+            validBytes = file.tellg();
+            uint32_t codepoint;
+            float metrics[5];
+            int32_t dims[2];
+            file.read(reinterpret_cast<char*>(&codepoint), sizeof(codepoint));
+            file.read(reinterpret_cast<char*>(metrics), sizeof(metrics));
+            file.read(reinterpret_cast<char*>(dims), sizeof(dims));
+            if (!file || dims[0] < 0 || dims[1] < 0 || dims[0] > WIDTH || dims[1] > HEIGHT)
+                break;
+
+            GlyphRecord glyph;
+            glyph.size = glm::vec2(metrics[0], metrics[1]);
+            glyph.bearing = glm::vec2(metrics[2], metrics[3]);
+            glyph.advance = metrics[4];
+            glyph.width = dims[0];
+            glyph.height = dims[1];
+            glyph.field.resize(static_cast<size_t>(glyph.width) * glyph.height);
+            file.read(reinterpret_cast<char*>(glyph.field.data()), glyph.field.size());
+            if (!file)
+                break;
+            records[codepoint] = std::move(glyph);
+        }
+    }
+    stats.fromCache = records.size();
+
+    if (valid)
+    {
+        // Cut off any partial record, then add new glyphs after the rest
+        std::error_code error;
+        std::filesystem::resize_file(cachePath, validBytes, error);
+        cacheFile.open(cachePath, std::ios::binary | std::ios::app);
+        return;
+    }
+
+    cacheFile.open(cachePath, std::ios::binary | std::ios::trunc);
+    cacheFile.write(GLYPH_CACHE_MAGIC, sizeof(GLYPH_CACHE_MAGIC));
+    cacheFile.write(reinterpret_cast<const char*>(&GLYPH_CACHE_VERSION), sizeof(GLYPH_CACHE_VERSION));
+    cacheFile.write(reinterpret_cast<const char*>(params), sizeof(params));
+    cacheFile.write(reinterpret_cast<const char*>(&fontBytes), sizeof(fontBytes));
+    cacheFile.flush();
+}
+
+void GlyphAtlas::appendToCache(uint32_t codepoint, const GlyphRecord& glyph)
+{
+    if (!cacheFile.is_open())
+        return;
+    const float metrics[5] = {glyph.size.x, glyph.size.y, glyph.bearing.x, glyph.bearing.y, glyph.advance};
+    const int32_t dims[2] = {glyph.width, glyph.height};
+    cacheFile.write(reinterpret_cast<const char*>(&codepoint), sizeof(codepoint));
+    cacheFile.write(reinterpret_cast<const char*>(metrics), sizeof(metrics));
+    cacheFile.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+    cacheFile.write(reinterpret_cast<const char*>(glyph.field.data()), glyph.field.size());
+    cacheFile.flush();
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include "mygl.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+/// Holds all state information relevant to a character as loaded using FreeType
+struct Character
+{
+    glm::vec2 UVMin;        // Top-left of the glyph in the atlas
+    glm::vec2 UVMax;        // Bottom-right of the glyph in the atlas
+    glm::vec2 Size;         // Size of the glyph's quad, padding included
+    glm::vec2 Bearing;      // Offset from baseline to left/top of the quad
+    float Advance;          // Horizontal offset to advance to next glyph
+};
+
+struct GlyphAtlasStats
+{
+    size_t resident = 0;   // glyphs in the texture now
+    size_t known = 0;      // distance fields held on the CPU, from the cache or FreeType
+    size_t fromCache = 0;  // of those, read from the cache file at startup
+    size_t rasterized = 0; // made with FreeType this run
+    size_t evictions = 0;  // glyphs dropped from the texture to make room
+    size_t failed = 0;     // lookups that found no room, so the glyph was skipped
+    float occupancy = 0.0f; // share of the texture's area holding resident glyphs
+};
+
+// Distance-field glyphs for any codepoint, made on first use and packed
+// into one texture on shelves: rows as tall as the first glyph that opened
+// them, filled left to right. When no shelf has room the one used least
+// recently is emptied, which only ever drops glyphs not drawn this frame.
+//
+// Fields made with FreeType are appended to a cache file, and the next
+// run reads them back, so FreeType is only started for a codepoint the
+// cache has never seen. Fields stay on the CPU, so a glyph evicted from
+// the texture comes back without rasterizing it again.
+class GlyphAtlas
+{
+public:
+    static constexpr int WIDTH = 1024;
+    static constexpr int HEIGHT = 256;
+
+    GlyphAtlas() = default;
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+    ~GlyphAtlas();
+
+    // Reads the cache and creates the texture
+    void init(const std::string& fontPath, const std::string& cachePath);
+    // The glyph for codepoint, put in the texture if it was not. Null when
+    // the font can't be opened or load it, or no room is left this frame.
+    // shelf, if given, gets the shelf holding it (-1 for glyphs with
+    // nothing to draw).
+    const Character* find(uint32_t codepoint, int* shelf = nullptr);
+    // Marks shelves from find as drawn this frame, for holders of glyph UVs
+    // that don't look them up again every frame
+    void touch(const std::vector<int>& shelves);
+    // Glyphs found before this may be evicted from now on
+    void endFrame() { frame++; }
+
+    unsigned int texture() const { return atlasTexture; }
+    // Changes whenever glyphs are evicted, so anything holding their UVs
+    // knows to lay out again
+    uint32_t generation() const { return evictionGeneration; }
+    // Whether any of the shelves lost its glyphs after generation() read
+    // `since`, for holders that only need to lay out when their own moved
+    bool evictedSince(const std::vector<int>& shelves, uint32_t since) const;
+    const GlyphAtlasStats& getStats();
+
+private:
+    struct GlyphRecord
+    {
+        glm::vec2 size;
+        glm::vec2 bearing;
+        float advance;
+        int width, height;
+        std::vector<unsigned char> field;
+    };
+    struct Slot
+    {
+        uint32_t codepoint;
+        int shelf; // -1 for glyphs with nothing to draw
+        int width, height;
+        Character character;
+    };
+    struct Shelf
+    {
+        int y, height, penX;
+        uint64_t lastUsed;
+        std::vector<int> slots;
+        uint32_t evictedAt = 0; // generation() right after its last eviction
+    };
+
+    const GlyphRecord* record(uint32_t codepoint);
+    bool openFont();
+    bool rasterize(uint32_t codepoint, GlyphRecord& out);
+    int place(uint32_t codepoint, const GlyphRecord& glyph);
+    int findShelf(int width, int height);
+    void evictShelf(int shelf);
+    void loadCache();
+    void appendToCache(uint32_t codepoint, const GlyphRecord& glyph);
+
+    std::string fontPath;
+    std::string cachePath;
+    std::ofstream cacheFile;
+    uint64_t fontBytes = 0;
+    FT_Library library = nullptr;
+    FT_Face face = nullptr;
+    bool fontFailed = false;
+
+    std::unordered_map<uint32_t, GlyphRecord> records;
+    // Codepoints the font couldn't load, so each is tried (and reported) once
+    std::unordered_set<uint32_t> failed;
+    std::vector<Slot> slots;
+    std::vector<int> freeSlots;
+    // Slot per codepoint in the texture, -1 if none; a flat array for ASCII
+    int asciiSlots[128];
+    std::unordered_map<uint32_t, int> otherSlots;
+    std::vector<Shelf> shelves;
+    int nextShelfY = 0;
+
+    uint64_t frame = 1;
+    uint32_t evictionGeneration = 0;
+    unsigned int atlasTexture = 0;
+    GlyphAtlasStats stats;
+};
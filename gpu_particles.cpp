@@ -0,0 +1,137 @@
+#include "gpu_particles.hpp"
+#include "resource_ids.hpp"
+#include "shader.hpp"
+#include <vector>
+
+GpuParticleProgram GpuParticleProgram::create() {
+    const char* varyings[] = {"outPositionLife", "outVelocitySize", "outColor", "outRender"};
+    GpuParticleProgram program;
+    program.id = Shader::CreateTransformFeedback(resources::path(resources::Shaders_particle_update_vertex),
+                                                 varyings, 4);
+    program.findUniforms();
+    return program;
+}
+
+void GpuParticleProgram::findUniforms() {
+    reloads = Shader::ReloadCount();
+    auto location = [&](const char* name) { return glGetUniformLocation(id, name); };
+    dt = location("dt");
+    seed = location("seed");
+    spawnStart = location("spawnStart");
+    spawnCount = location("spawnCount");
+    capacity = location("capacity");
+    spawnPosition = location("spawnPosition");
+    spawnPositionVariance = location("spawnPositionVariance");
+    initialVelocity = location("initialVelocity");
+    velocityVariance = location("velocityVariance");
+    particleLifetime = location("particleLifetime");
+    lifetimeVariance = location("lifetimeVariance");
+    startSize = location("startSize");
+    endSize = location("endSize");
+    sizeVariance = location("sizeVariance");
+    startColor = location("startColor");
+    endColor = location("endColor");
+    gravity = location("gravity");
+    damping = location("damping");
+    rotationSpeed = location("rotationSpeed");
+    rotationVariance = location("rotationVariance");
+}
+
+GpuParticleSim::GpuParticleSim(size_t capacity, GLuint quadVBO, GLuint quadEBO) : slots(capacity) {
+    // Zeroed slots have no life left, so everything starts dead
+    std::vector<GpuParticle> initial(slots, GpuParticle{glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f)});
+
+    glGenBuffers(2, buffers);
+    glGenVertexArrays(2, updateVAO);
+    glGenVertexArrays(2, renderVAO);
+
+    const GLsizei stride = sizeof(GpuParticle);
+    for (int i = 0; i < 2; i++) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, slots * sizeof(GpuParticle), initial.data(), GL_DYNAMIC_COPY);
+
+        // Update pass reads the whole slot
+        glBindVertexArray(updateVAO[i]);
+        for (GLuint attribute = 0; attribute < 4; attribute++) {
+            glEnableVertexAttribArray(attribute);
+            glVertexAttribPointer(attribute, 4, GL_FLOAT, GL_FALSE, stride, (void*)(attribute * sizeof(glm::vec4)));
+        }
+
+        // Render pass: the shared quad (position + uv, 5 floats) plus the instance attributes
+        // particle_vertex.glsl expects, pointed into the same slots
+        glBindVertexArray(renderVAO[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadEBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GpuParticle, positionLife));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GpuParticle, color));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GpuParticle, render));
+        glEnableVertexAttribArray(5);
+        glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, stride, (void*)(offsetof(GpuParticle, render) + sizeof(float)));
+        for (GLuint attribute = 2; attribute <= 5; attribute++) glVertexAttribDivisor(attribute, 1);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+GpuParticleSim::~GpuParticleSim() {
+    glDeleteVertexArrays(2, renderVAO);
+    glDeleteVertexArrays(2, updateVAO);
+    glDeleteBuffers(2, buffers);
+}
+
+void GpuParticleSim::step(const GpuParticleProgram& program, const ParticleEmitterConfig& config, float dt,
+                          size_t spawnCount, uint32_t seed) {
+    if (spawnCount > slots) spawnCount = slots;
+
+    glUseProgram(program.id);
+    glUniform1f(program.dt, dt);
+    glUniform1ui(program.seed, seed);
+    glUniform1i(program.spawnStart, static_cast<GLint>(spawnCursor));
+    glUniform1i(program.spawnCount, static_cast<GLint>(spawnCount));
+    glUniform1i(program.capacity, static_cast<GLint>(slots));
+    glUniform3fv(program.spawnPosition, 1, &config.spawnPosition[0]);
+    glUniform3fv(program.spawnPositionVariance, 1, &config.spawnPositionVariance[0]);
+    glUniform3fv(program.initialVelocity, 1, &config.initialVelocity[0]);
+    glUniform3fv(program.velocityVariance, 1, &config.velocityVariance[0]);
+    glUniform1f(program.particleLifetime, config.particleLifetime);
+    glUniform1f(program.lifetimeVariance, config.lifetimeVariance);
+    glUniform1f(program.startSize, config.startSize);
+    glUniform1f(program.endSize, config.endSize);
+    glUniform1f(program.sizeVariance, config.sizeVariance);
+    glUniform4fv(program.startColor, 1, &config.startColor[0]);
+    glUniform4fv(program.endColor, 1, &config.endColor[0]);
+    glUniform3fv(program.gravity, 1, &config.gravity[0]);
+    glUniform1f(program.damping, config.damping);
+    glUniform1f(program.rotationSpeed, config.rotationSpeed);
+    glUniform1f(program.rotationVariance, config.rotationVariance);
+
+    int next = 1 - current;
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(updateVAO[current]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[next]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(slots));
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    current = next;
+    spawnCursor = (spawnCursor + spawnCount) % slots;
+}
+
+void GpuParticleSim::draw() const {
+    glBindVertexArray(renderVAO[current]);
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(slots));
+    glBindVertexArray(0);
+}
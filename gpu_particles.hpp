@@ -0,0 +1,66 @@
+#pragma once
+#include "mygl.h"
+#include "particle_simulation.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// One slot of GPU particle state. Written by transform feedback and read
+// back as instance attributes, so it is laid out like the varyings in
+// particle_update_vertex.glsl.
+struct GpuParticle {
+    glm::vec4 positionLife;
+    glm::vec4 velocitySize;
+    glm::vec4 color;
+    glm::vec4 render; // drawn size, rotation, spin, unused
+};
+
+// The transform feedback update program and its uniform locations,
+// shared by every GPU emitter
+struct GpuParticleProgram {
+    GLuint id = 0;
+    GLint dt, seed, spawnStart, spawnCount, capacity;
+    GLint spawnPosition, spawnPositionVariance, initialVelocity, velocityVariance;
+    GLint particleLifetime, lifetimeVariance, startSize, endSize, sizeVariance;
+    GLint startColor, endColor, gravity, damping, rotationSpeed, rotationVariance;
+
+    uint32_t reloads = 0; // Shader::ReloadCount() when the locations were looked up
+
+    static GpuParticleProgram create();
+    // Looks the uniform locations up again, after the program was reloaded
+    void findUniforms();
+};
+
+// Particle state for one emitter living entirely on the GPU. Two buffers
+// ping-pong: each step draws every slot of one as points with the
+// rasterizer off and transform feedback captures the update into the
+// other. Nothing is read back or uploaded per frame.
+//
+// Slots are spawned in ring order; a slot still alive when its turn comes
+// skips that spawn, so capacity should cover rate * lifetime.
+class GpuParticleSim {
+public:
+    // The quad buffers come from the ParticleManager, shared with the
+    // CPU path
+    GpuParticleSim(size_t capacity, GLuint quadVBO, GLuint quadEBO);
+    ~GpuParticleSim();
+    GpuParticleSim(const GpuParticleSim&) = delete;
+    GpuParticleSim& operator=(const GpuParticleSim&) = delete;
+
+    void step(const GpuParticleProgram& program, const ParticleEmitterConfig& config, float dt,
+              size_t spawnCount, uint32_t seed);
+
+    // Instanced draw of every slot with whichever shader is bound
+    void draw() const;
+
+    size_t capacity() const { return slots; }
+    GLuint stateBuffer() const { return buffers[current]; }
+
+private:
+    size_t slots;
+    size_t spawnCursor = 0;
+    int current = 0;
+
+    GLuint buffers[2] = {};
+    GLuint updateVAO[2] = {};
+    GLuint renderVAO[2] = {};
+};
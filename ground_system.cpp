@@ -1,17 +1,38 @@
 #include "ground_system.hpp"
 #include "camera.hpp"
+#include "heightfield.hpp"
 #include <cmath>
 
+// Camera sits this far above the ground it stands on
+static constexpr float EYE_HEIGHT = 1.0f;
+// Highest ledge the feet can step onto without it counting as a wall
+static constexpr float MAX_STEP_UP = 0.5f;
+
 struct Ground {
   float y;
+  glm::vec3 normal;
 };
 
 Ground ground;
 
-void ground_system_init() { ground.y = 0.0f; }
-
+void ground_system_init() {
+  ground.y = 0.0f;
+  ground.normal = glm::vec3(0, 1, 0);
+}
 
 void ground_system_update(float dt) {
   Camera &camera = entt::locator<Camera>::value();
-  camera.Position.y = 1;
+
+  // Without a baked surface under the feet (off the heightfield, or a
+  // gap in it) stay at the last ground height; it starts at y = 0
+  float height;
+  glm::vec3 normal;
+  glm::vec3 feet = camera.Position - glm::vec3(0, EYE_HEIGHT, 0);
+  if (entt::locator<Heightfield>::has_value() &&
+      entt::locator<Heightfield>::value().query(feet, MAX_STEP_UP, height, normal)) {
+    ground.y = height;
+    ground.normal = normal;
+  }
+
+  camera.Position.y = ground.y + EYE_HEIGHT;
 }
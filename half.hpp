@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+// IEEE 754 binary16 conversions, for vertex data uploaded as GL_HALF_FLOAT.
+// Branch-light bit manipulation after Fabian Giesen's float_to_half_fast3_rtne
+// and half_to_float_fast4; rounds to nearest even, overflow gives infinity.
+inline uint16_t float_to_half(float value) {
+    const uint32_t f32infty = 255u << 23;
+    const uint32_t f16max = (127u + 16u) << 23;
+    const uint32_t denormMagicBits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    uint32_t f;
+    std::memcpy(&f, &value, sizeof(f));
+    uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+
+    uint16_t out;
+    if (f >= f16max) {
+        out = f > f32infty ? 0x7e00 : 0x7c00; // NaN stays NaN, the rest is infinity
+    } else if (f < (113u << 23)) {
+        // Too small for a normal half: let the FPU shift the mantissa
+        float shifted, magic;
+        std::memcpy(&shifted, &f, sizeof(f));
+        std::memcpy(&magic, &denormMagicBits, sizeof(magic));
+        shifted += magic;
+        uint32_t bits;
+        std::memcpy(&bits, &shifted, sizeof(bits));
+        out = static_cast<uint16_t>(bits - denormMagicBits);
+    } else {
+        uint32_t mantissaOdd = (f >> 13) & 1;
+        f += (static_cast<uint32_t>(15 - 127) << 23) + 0xfff;
+        f += mantissaOdd;
+        out = static_cast<uint16_t>(f >> 13);
+    }
+    return out | static_cast<uint16_t>(sign >> 16);
+}
+
+inline float half_to_float(uint16_t half) {
+    const uint32_t shiftedExp = 0x7c00u << 13;
+
+    uint32_t bits = (half & 0x7fffu) << 13;
+    uint32_t exp = shiftedExp & bits;
+    bits += (127u - 15u) << 23;
+
+    if (exp == shiftedExp) {
+        bits += (128u - 16u) << 23; // infinity / NaN
+    } else if (exp == 0) {
+        // Denormal: renormalize through the FPU
+        bits += 1u << 23;
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        f -= 6.103515625e-05f; // 2^-14
+        std::memcpy(&bits, &f, sizeof(bits));
+    }
+    bits |= static_cast<uint32_t>(half & 0x8000u) << 16;
+
+    float out;
+    std::memcpy(&out, &bits, sizeof(out));
+    return out;
+}
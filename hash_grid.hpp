@@ -1,7 +1,9 @@
 #pragma once
 #include "mygl.h"
 #include "camera.hpp"
+#include "culling.hpp"
 #include "model.hpp"
+#include "job_system.hpp"
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -28,39 +30,11 @@ struct SpatialObject {
 
 class SpatialHashGrid {
 private:
-float distanceToPlane(const glm::vec4& plane, const glm::vec3& point) {
-    return glm::dot(glm::vec3(plane), point) + plane.w;
-}
-
-bool isAABBOutsidePlane(const AABB& aabb, const glm::vec4& plane) {
-    // Get the vertex closest to the plane (negative vertex)
-    glm::vec3 negativeVertex;
-    negativeVertex.x = (plane.x < 0.0f) ? aabb.max.x : aabb.min.x;
-    negativeVertex.y = (plane.y < 0.0f) ? aabb.max.y : aabb.min.y;
-    negativeVertex.z = (plane.z < 0.0f) ? aabb.max.z : aabb.min.z;
-
-    // If the closest vertex is outside (negative distance), the entire AABB is outside
-    return distanceToPlane(plane, negativeVertex) < 0.0f;
-}
-
-// Test if AABB is within or intersects the frustum
-bool isAABBInFrustum(const AABB& aabb, const Frustum& frustum) {
-    // Test against all 6 frustum planes
-    for (int i = 0; i < 6; i++) {
-        if (isAABBOutsidePlane(aabb, frustum.planes[i])) {
-            return false; // AABB is completely outside this plane
-        }
-    }
-    return true; // AABB is inside or intersects the frustum
-}
-
-
-
-
     float cellSize;
     std::unordered_map<glm::ivec3, std::vector<ObjectHandle>, GridCoordHash> grid;
     std::unordered_map<ObjectHandle, SpatialObject> objects;
     std::unordered_map<ObjectHandle, std::unordered_set<glm::ivec3, GridCoordHash>> objectCells;
+    CullScratch cullScratch;
 
     // Convert world position to grid coordinate
     glm::ivec3 worldToGrid(const glm::vec3& worldPos) const {
@@ -220,21 +194,37 @@ public:
 
 
 
-    // Helper function to perform complete culling pipeline
+    // Helper function to perform complete culling pipeline. With a job system the
+    // precise pass is split across its threads, each filling its own list.
     std::vector<ObjectHandle> cullObjects(
         const Camera& camera,
         float nearPlane = 0.1f,
-        float farPlane = 100.0f) {
+        float farPlane = 100.0f,
+        JobSystem* jobs = nullptr) {
 
         // Step 1: Coarse culling with spatial hash
         auto candidates = queryFrustum(camera, nearPlane, farPlane);
 
         // Step 2: Precise frustum culling
         std::vector<ObjectHandle> visibleObjects;
-        for (ObjectHandle handle : candidates) {
-            const SpatialObject* obj = getObject(handle);
-            if (obj && isAABBInFrustum(obj->aabb, camera.ViewFrustum)) {
-                visibleObjects.push_back(handle);
+        if (jobs) {
+            cull_scratch_reset(*jobs, cullScratch);
+            jobs->parallel_for(candidates.size(), 1024, [&](size_t begin, size_t end, unsigned int slot) {
+                auto& out = cullScratch.perSlot[slot];
+                for (size_t i = begin; i < end; i++) {
+                    const SpatialObject* obj = getObject(candidates[i]);
+                    if (obj && aabb_in_frustum(obj->aabb, camera.ViewFrustum)) {
+                        out.push_back(candidates[i]);
+                    }
+                }
+            });
+            cull_scratch_merge(*jobs, cullScratch, visibleObjects);
+        } else {
+            for (ObjectHandle handle : candidates) {
+                const SpatialObject* obj = getObject(handle);
+                if (obj && aabb_in_frustum(obj->aabb, camera.ViewFrustum)) {
+                    visibleObjects.push_back(handle);
+                }
             }
         }
 
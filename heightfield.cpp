@@ -0,0 +1,197 @@
+#include "heightfield.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+static const char HEIGHTFIELD_MAGIC[4] = {'H', 'F', 'L', 'D'};
+static constexpr uint32_t HEIGHTFIELD_VERSION = 1;
+
+void heightfield_collect_model(const Model& model, std::vector<glm::vec3>& triangles) {
+    for (const auto& mesh : model.meshes) {
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            for (int k = 0; k < 3; k++) {
+                const glm::vec3& p = mesh.vertices[mesh.indices[i + k]].Position;
+                triangles.push_back(glm::vec3(model.transform * glm::vec4(p, 1.0f)));
+            }
+        }
+    }
+}
+
+Heightfield heightfield_bake(const std::vector<glm::vec3>& triangles, const HeightfieldBakeSettings& settings) {
+    Heightfield field;
+    field.cellSize = settings.cellSize;
+    field.layers = settings.maxLayers;
+    if (triangles.size() < 3) return field;
+
+    AABB bounds;
+    for (const auto& p : triangles) bounds.expand(p);
+    field.origin = glm::vec2(bounds.min.x, bounds.min.z);
+    field.width = static_cast<int>(std::ceil((bounds.max.x - bounds.min.x) / settings.cellSize)) + 1;
+    field.depth = static_cast<int>(std::ceil((bounds.max.z - bounds.min.z) / settings.cellSize)) + 1;
+
+    // Every surface sample first, layered once all are in. Flat arrays
+    // grouped by cell keep the bake to a handful of allocations.
+    struct CellSample {
+        uint32_t cell;
+        float height;
+    };
+    std::vector<CellSample> samples;
+
+    for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+        const glm::vec3& a = triangles[t];
+        const glm::vec3& b = triangles[t + 1];
+        const glm::vec3& c = triangles[t + 2];
+
+        // Only upward-facing, walkable triangles are ground. Winding is not
+        // reliable across assets, so use the absolute normal.
+        glm::vec3 n = glm::cross(b - a, c - a);
+        float len = glm::length(n);
+        if (len < 1e-12f || std::fabs(n.y) / len < settings.minWalkableNormalY) continue;
+
+        // Barycentric set-up in the xz plane
+        float area = (b.x - a.x) * (c.z - a.z) - (c.x - a.x) * (b.z - a.z);
+        if (std::fabs(area) < 1e-12f) continue;
+        float invArea = 1.0f / area;
+
+        int x0 = std::max(0, static_cast<int>(std::floor((std::min({a.x, b.x, c.x}) - field.origin.x) / field.cellSize)));
+        int x1 = std::min(field.width - 1, static_cast<int>(std::ceil((std::max({a.x, b.x, c.x}) - field.origin.x) / field.cellSize)));
+        int z0 = std::max(0, static_cast<int>(std::floor((std::min({a.z, b.z, c.z}) - field.origin.y) / field.cellSize)));
+        int z1 = std::min(field.depth - 1, static_cast<int>(std::ceil((std::max({a.z, b.z, c.z}) - field.origin.y) / field.cellSize)));
+
+        for (int z = z0; z <= z1; z++) {
+            float pz = field.origin.y + z * field.cellSize;
+            for (int x = x0; x <= x1; x++) {
+                float px = field.origin.x + x * field.cellSize;
+                float w1 = ((px - a.x) * (c.z - a.z) - (c.x - a.x) * (pz - a.z)) * invArea;
+                float w2 = ((b.x - a.x) * (pz - a.z) - (px - a.x) * (b.z - a.z)) * invArea;
+                float w0 = 1.0f - w1 - w2;
+                // Small tolerance so shared edges leave no cracks
+                const float eps = -1e-4f;
+                if (w0 < eps || w1 < eps || w2 < eps) continue;
+                samples.push_back({static_cast<uint32_t>(z * field.width + x), w0 * a.y + w1 * b.y + w2 * c.y});
+            }
+        }
+    }
+
+    // Counting sort by cell: offsets[cell] .. offsets[cell + 1] are its heights
+    size_t cellCount = static_cast<size_t>(field.width) * field.depth;
+    std::vector<uint32_t> offsets(cellCount + 1, 0);
+    for (const auto& sample : samples) offsets[sample.cell + 1]++;
+    for (size_t cell = 0; cell < cellCount; cell++) offsets[cell + 1] += offsets[cell];
+    std::vector<float> heights(samples.size());
+    std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (const auto& sample : samples) heights[cursor[sample.cell]++] = sample.height;
+
+    field.heights.assign(cellCount * field.layers, Heightfield::EMPTY);
+    for (size_t cell = 0; cell < cellCount; cell++) {
+        float* begin = heights.data() + offsets[cell];
+        float* end = heights.data() + offsets[cell + 1];
+        std::sort(begin, end, std::greater<float>());
+
+        // Keep the top of every cluster: a floor's thickness or a stack of
+        // coplanar decals collapses into one walkable layer
+        int layer = 0;
+        float last = INFINITY;
+        for (const float* h = begin; h != end && layer < field.layers; h++) {
+            if (last - *h < settings.minLayerGap) continue;
+            field.heights[cell * field.layers + layer++] = *h;
+            last = *h;
+        }
+    }
+
+    return field;
+}
+
+bool Heightfield::query(const glm::vec3& pos, float maxStepUp, float& height, glm::vec3& normal) const {
+    if (heights.empty()) return false;
+
+    float fx = (pos.x - origin.x) / cellSize;
+    float fz = (pos.z - origin.y) / cellSize;
+    int x0 = static_cast<int>(std::floor(fx));
+    int z0 = static_cast<int>(std::floor(fz));
+    if (x0 < 0 || z0 < 0 || x0 + 1 >= width || z0 + 1 >= depth) return false;
+    float tx = fx - x0;
+    float tz = fz - z0;
+
+    // Per corner, the highest layer the feet can stand on
+    float limit = pos.y + maxStepUp;
+    float corner[4];
+    int found = 0;
+    float nearest = EMPTY;
+    for (int k = 0; k < 4; k++) {
+        int x = x0 + (k & 1);
+        int z = z0 + (k >> 1);
+        corner[k] = EMPTY;
+        for (int layer = 0; layer < layers; layer++) {
+            float h = at(x, z, layer);
+            if (h != EMPTY && h <= limit) {
+                corner[k] = h;
+                found++;
+                nearest = std::max(nearest, h);
+                break;
+            }
+        }
+    }
+    if (found == 0) return false;
+
+    // At a ledge some corners have no surface; use the one we stand on
+    for (float& h : corner) {
+        if (h == EMPTY) h = nearest;
+    }
+
+    float top = corner[0] + (corner[1] - corner[0]) * tx;
+    float bottom = corner[2] + (corner[3] - corner[2]) * tx;
+    height = top + (bottom - top) * tz;
+
+    float dhdx = ((corner[1] - corner[0]) * (1.0f - tz) + (corner[3] - corner[2]) * tz) / cellSize;
+    float dhdz = ((corner[2] - corner[0]) * (1.0f - tx) + (corner[3] - corner[1]) * tx) / cellSize;
+    normal = glm::normalize(glm::vec3(-dhdx, 1.0f, -dhdz));
+    return true;
+}
+
+bool Heightfield::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    int32_t dims[3] = {width, depth, layers};
+    file.write(HEIGHTFIELD_MAGIC, sizeof(HEIGHTFIELD_MAGIC));
+    file.write(reinterpret_cast<const char*>(&HEIGHTFIELD_VERSION), sizeof(HEIGHTFIELD_VERSION));
+    file.write(reinterpret_cast<const char*>(&origin.x), sizeof(float));
+    file.write(reinterpret_cast<const char*>(&origin.y), sizeof(float));
+    file.write(reinterpret_cast<const char*>(&cellSize), sizeof(float));
+    file.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+    file.write(reinterpret_cast<const char*>(heights.data()), heights.size() * sizeof(float));
+    return file.good();
+}
+
+bool Heightfield::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    char magic[4];
+    uint32_t version = 0;
+    int32_t dims[3];
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!file || std::memcmp(magic, HEIGHTFIELD_MAGIC, sizeof(magic)) != 0 || version != HEIGHTFIELD_VERSION) {
+        return false;
+    }
+
+    file.read(reinterpret_cast<char*>(&origin.x), sizeof(float));
+    file.read(reinterpret_cast<char*>(&origin.y), sizeof(float));
+    file.read(reinterpret_cast<char*>(&cellSize), sizeof(float));
+    file.read(reinterpret_cast<char*>(dims), sizeof(dims));
+    if (!file || dims[0] <= 0 || dims[1] <= 0 || dims[2] <= 0) return false;
+
+    width = dims[0];
+    depth = dims[1];
+    layers = dims[2];
+    heights.resize(static_cast<size_t>(width) * depth * layers);
+    file.read(reinterpret_cast<char*>(heights.data()), heights.size() * sizeof(float));
+    if (!file) {
+        heights.clear();
+        return false;
+    }
+    return true;
+}
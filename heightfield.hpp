@@ -0,0 +1,45 @@
+#pragma once
+#include "model.hpp"
+#include <string>
+#include <vector>
+
+// Top-down height grid of walkable surfaces. Every cell stores up to
+// `layers` surface heights, highest first, so bridges and upper floors
+// keep the ground underneath them. Queries touch four cells and are
+// constant time whatever the scene size.
+struct Heightfield {
+    static constexpr float EMPTY = -1e30f;
+
+    glm::vec2 origin{0.0f}; // world xz of cell (0, 0)
+    float cellSize = 0.25f;
+    int width = 0;
+    int depth = 0;
+    int layers = 0;
+    std::vector<float> heights; // [(z * width + x) * layers + layer]
+
+    bool empty() const { return heights.empty(); }
+
+    float at(int x, int z, int layer) const {
+        return heights[(static_cast<size_t>(z) * width + x) * layers + layer];
+    }
+
+    // Height and normal of the highest surface at most maxStepUp above
+    // pos.y, bilinearly interpolated. False when there is none.
+    bool query(const glm::vec3& pos, float maxStepUp, float& height, glm::vec3& normal) const;
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+};
+
+struct HeightfieldBakeSettings {
+    float cellSize = 0.25f;
+    int maxLayers = 4;
+    float minLayerGap = 1.5f;     // surfaces closer than this merge into one layer
+    float minWalkableNormalY = 0.5f; // steeper triangles are walls, not ground
+};
+
+// Rasterizes world-space triangles (three vertices each) from above
+Heightfield heightfield_bake(const std::vector<glm::vec3>& triangles, const HeightfieldBakeSettings& settings);
+
+// Appends the world-space triangles of a model's meshes
+void heightfield_collect_model(const Model& model, std::vector<glm::vec3>& triangles);
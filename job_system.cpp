@@ -0,0 +1,191 @@
+#include "job_system.hpp"
+#include <algorithm>
+#include <cassert>
+
+// Slot of the thread inside the job system that owns it. Threads outside
+// any job system (and the main thread) read 0.
+static thread_local const JobSystem* currentSystem = nullptr;
+static thread_local unsigned int currentSlot = 0;
+
+JobSystem::JobSystem(unsigned int threadCount) {
+    slotCount = std::max(threadCount, 1u);
+    mainThread = std::this_thread::get_id();
+    queues = std::make_unique<WorkQueue[]>(slotCount);
+    workers.reserve(slotCount - 1);
+    for (unsigned int slot = 1; slot < slotCount; slot++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, slot);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+unsigned int JobSystem::current_slot() const {
+    if (currentSystem == this) return currentSlot;
+    // A foreign thread would share the main thread's deque and scratch slot,
+    // and could run main-thread (GL) jobs while waiting
+    assert(std::this_thread::get_id() == mainThread && "JobSystem used from a foreign thread");
+    return 0;
+}
+
+void JobSystem::push(Job job, JobAffinity affinity) {
+    if (affinity == JobAffinity::Main) {
+        std::lock_guard<std::mutex> lock(mainQueue.mutex);
+        mainQueue.jobs.push_back(std::move(job));
+        return;
+    }
+
+    WorkQueue& queue = queues[current_slot()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+    queued.fetch_add(1, std::memory_order_release);
+
+    // Taking the lock orders this against a worker about to sleep
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    wake.notify_one();
+}
+
+bool JobSystem::pop(unsigned int slot, Job& job) {
+    WorkQueue& queue = queues[slot];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) return false;
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool JobSystem::steal(unsigned int slot, Job& job) {
+    unsigned int count = size();
+    for (unsigned int i = 1; i < count; i++) {
+        WorkQueue& queue = queues[(slot + i) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) continue;
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::popMain(Job& job) {
+    std::lock_guard<std::mutex> lock(mainQueue.mutex);
+    if (mainQueue.jobs.empty()) return false;
+    job = std::move(mainQueue.jobs.front());
+    mainQueue.jobs.pop_front();
+    return true;
+}
+
+bool JobSystem::runOne(unsigned int slot) {
+    Job job;
+    if ((slot == 0 && popMain(job)) || pop(slot, job) || steal(slot, job)) {
+        execute(job);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::execute(Job& job) {
+    job.fn();
+    finish(job.counter);
+}
+
+void JobSystem::finish(JobCounter* counter) {
+    if (!counter) return;
+
+    // Decrement under the lock: wait() takes it once more before returning,
+    // so the counter cannot be destroyed while we still hold it
+    std::vector<JobCounter::Continuation> ready;
+    {
+        std::lock_guard<std::mutex> lock(counter->mutex);
+        if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        ready.swap(counter->continuations);
+    }
+    // Already counted by run_after
+    for (auto& next : ready) {
+        push({std::move(next.fn), next.counter}, next.affinity);
+    }
+}
+
+void JobSystem::run(std::function<void()> fn, JobCounter* counter, JobAffinity affinity) {
+    if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+    push({std::move(fn), counter}, affinity);
+}
+
+void JobSystem::run_after(JobCounter& dependency, std::function<void()> fn, JobCounter* counter,
+                          JobAffinity affinity) {
+    // Counted now, so waiting on counter also covers jobs not queued yet
+    if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(dependency.mutex);
+        if (!dependency.done()) {
+            dependency.continuations.push_back({std::move(fn), counter, affinity});
+            return;
+        }
+    }
+    push({std::move(fn), counter}, affinity);
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    unsigned int slot = current_slot();
+    while (!counter.done()) {
+        if (!runOne(slot)) {
+            std::this_thread::yield();
+        }
+    }
+    std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void JobSystem::run_main_jobs() {
+    Job job;
+    while (popMain(job)) {
+        execute(job);
+    }
+}
+
+void JobSystem::workerLoop(unsigned int slot) {
+    currentSystem = this;
+    currentSlot = slot;
+
+    for (;;) {
+        if (runOne(slot)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [&] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping) return;
+    }
+}
+
+void JobSystem::parallel_for(size_t count, size_t minChunk, const RangeFn& fn) {
+    if (count == 0) return;
+
+    // Aim for a few chunks per thread so uneven chunks still balance out
+    size_t chunks = static_cast<size_t>(size()) * 4;
+    size_t chunk = std::max<size_t>(std::max<size_t>(minChunk, 1), (count + chunks - 1) / chunks);
+
+    if (slotCount == 1 || chunk >= count) {
+        fn(0, count, current_slot());
+        return;
+    }
+
+    // Queue all but the first chunk for others to steal and run that one here
+    JobCounter counter;
+    for (size_t begin = chunk; begin < count; begin += chunk) {
+        size_t end = std::min(begin + chunk, count);
+        run([&fn, this, begin, end] { fn(begin, end, current_slot()); }, &counter);
+    }
+    fn(0, chunk, current_slot());
+
+    wait(counter);
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// Where a job may run. GL calls must stay on the thread owning the context,
+// so those jobs go to a queue only the main thread drains.
+enum class JobAffinity { Any, Main };
+
+// Counts unfinished jobs. Jobs started with a counter bump it and drop it
+// when they finish; jobs queued with run_after start once it hits zero.
+// Only destroy a counter after JobSystem::wait on it has returned.
+class JobCounter {
+public:
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    struct Continuation {
+        std::function<void()> fn;
+        JobCounter* counter;
+        JobAffinity affinity;
+    };
+
+    std::atomic<int> pending{0};
+    std::mutex mutex;
+    std::vector<Continuation> continuations;
+};
+
+// Work-stealing scheduler. Every thread owns a deque: it pushes and pops
+// at the back (newest first, still hot in cache) and idle threads steal
+// from the front of someone else's. The main thread is slot 0 and runs
+// jobs whenever it waits, so a system of size 1 runs everything inline.
+// The main thread is the one that created the system; only it and the
+// workers may queue jobs or wait, as any other thread would share slot 0.
+class JobSystem {
+public:
+    // fn(begin, end, slot) - slot is stable for the thread running the chunk
+    // and lies in [0, size()), so callers can keep per-slot scratch buffers.
+    using RangeFn = std::function<void(size_t, size_t, unsigned int)>;
+
+    explicit JobSystem(unsigned int threadCount = std::thread::hardware_concurrency());
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Number of threads running jobs, including the main thread
+    unsigned int size() const { return slotCount; }
+
+    // Slot of the calling thread, 0 on the main thread. Asserts on threads
+    // outside the system.
+    unsigned int current_slot() const;
+
+    void run(std::function<void()> fn, JobCounter* counter = nullptr,
+             JobAffinity affinity = JobAffinity::Any);
+
+    // Queues fn once every job counted by dependency has finished
+    void run_after(JobCounter& dependency, std::function<void()> fn, JobCounter* counter = nullptr,
+                   JobAffinity affinity = JobAffinity::Any);
+
+    // Runs other jobs until counter reaches zero. Waiting on the main thread
+    // also drains main-thread jobs, so waiting on them cannot deadlock.
+    void wait(JobCounter& counter);
+
+    // Runs the main-thread jobs queued so far. Call once a frame from the
+    // main thread so they run even when nobody waits on them.
+    void run_main_jobs();
+
+    // Runs fn over [0, count) in chunks of at least minChunk and blocks until
+    // done. Safe to nest: the waiting thread keeps executing chunks.
+    void parallel_for(size_t count, size_t minChunk, const RangeFn& fn);
+
+    // parallel_for over the entities of an entt view, fn(entity, slot). The
+    // view's components must not be added or removed while it runs.
+    template <typename View, typename Fn>
+    void parallel_for_view(const View& view, size_t minChunk, Fn&& fn) {
+        std::vector<typename View::entity_type> entities(view.begin(), view.end());
+        parallel_for(entities.size(), minChunk, [&](size_t begin, size_t end, unsigned int slot) {
+            for (size_t i = begin; i < end; i++) {
+                fn(entities[i], slot);
+            }
+        });
+    }
+
+private:
+    struct Job {
+        std::function<void()> fn;
+        JobCounter* counter = nullptr;
+    };
+
+    // Own cache line each, so pushes on one thread do not slow the others
+    struct alignas(64) WorkQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void push(Job job, JobAffinity affinity);
+    bool pop(unsigned int slot, Job& job);
+    bool steal(unsigned int slot, Job& job);
+    bool popMain(Job& job);
+    // Runs one job if any is available to this thread
+    bool runOne(unsigned int slot);
+    void execute(Job& job);
+    void finish(JobCounter* counter);
+    void workerLoop(unsigned int slot);
+
+    // Fixed before the workers start, they read it while stealing
+    unsigned int slotCount = 1;
+    std::thread::id mainThread;
+    std::vector<std::thread> workers;
+    std::unique_ptr<WorkQueue[]> queues;
+    WorkQueue mainQueue;
+
+    // Jobs sitting in the stealable queues, so idle workers know to look
+    std::atomic<int> queued{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
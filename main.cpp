@@ -11,40 +11,66 @@
 #include <assimp/postprocess.h>
 
 #include "camera.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 
 #include <entt/entt.hpp>
 #include "game.hpp"
+#include "benchmarks.hpp"
+#include "tests.hpp"
+#include "text_renderer.hpp"
 
 
 void fps_counter_init();
-void fps_counter_update();
+void fps_counter_update(int ticks, double tickTime, double renderTime);
 
 
 #include <iostream>
 
 static double last_log_time = 0.0;
 static int frame_count = 0;
+static int tick_count = 0;
+static double tick_seconds = 0.0;
+static double render_seconds = 0.0;
 static const double LOG_INTERVAL = 3.0; // seconds
 
 void fps_counter_init() {
     last_log_time = glfwGetTime();
     frame_count = 0;
+    tick_count = 0;
+    tick_seconds = 0.0;
+    render_seconds = 0.0;
 }
 
-void fps_counter_update() {
+// ticks / tickTime: simulation steps run this frame and their total cost,
+// renderTime: CPU time spent drawing the frame
+void fps_counter_update(int ticks, double tickTime, double renderTime) {
     frame_count++;
+    tick_count += ticks;
+    tick_seconds += tickTime;
+    render_seconds += renderTime;
 
     double current_time = glfwGetTime();
     double elapsed = current_time - last_log_time;
 
     if (elapsed >= LOG_INTERVAL) {
         double fps = frame_count / elapsed;
-        std::cout << "FPS: " << fps << std::endl;
+        double msPerTick = tick_count > 0 ? tick_seconds * 1000.0 / tick_count : 0.0;
+        std::cout << "FPS: " << fps
+                  << " | sim: " << tick_count / elapsed << " ticks/s, " << msPerTick << " ms/tick"
+                  << " | render: " << render_seconds * 1000.0 / frame_count << " ms/frame"
+                  << " | text: " << text_stats().glyphs << " glyphs, " << text_stats().drawCalls << " draws, atlas "
+                  << static_cast<int>(text_stats().atlas.occupancy * 100.0f) << "% of "
+                  << text_stats().atlas.resident << " glyphs"
+                  << std::endl;
 
         // Reset for next interval
         last_log_time = current_time;
         frame_count = 0;
+        tick_count = 0;
+        tick_seconds = 0.0;
+        render_seconds = 0.0;
     }
 }
 
@@ -59,8 +85,15 @@ float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 
+// Length of the step being simulated; input scales movement by it
 float deltaTime = 0.0f;
-float lastFrame = 0.0f;
+
+// Simulation runs at a fixed rate, rendering as fast as it can and blending
+// between the last two ticks
+static double simTickRate = 60.0;
+// After a long stall drop the backlog instead of trying to catch up on it
+static const int MAX_TICKS_PER_FRAME = 8;
+static const double MAX_FRAME_TIME = 0.25;
 
 // Input processing functions
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
@@ -70,9 +103,27 @@ void processInput(GLFWwindow *window);
 
 
 
-int main()
+int main(int argc, char **argv)
 {
+    // Headless benchmarks skip window and context creation entirely
+    if (argc >= 3 && std::string(argv[1]) == "--bench")
+    {
+        return run_benchmark(argv[2]);
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--test")
+    {
+        return run_tests(argv[2]);
+    }
 
+    bool uncapped = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--sim-hz" && i + 1 < argc)
+            simTickRate = std::max(1.0, std::atof(argv[++i]));
+        else if (arg == "--uncapped")
+            uncapped = true;
+    }
 
     // Initialize GLFW
     glfwInit();
@@ -85,7 +136,7 @@ int main()
 #endif
 
     // Create window
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "3D OpenGL Renderer", NULL, NULL);
+    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, WINDOW_TITLE, NULL, NULL);
     entt::locator<Meta>::emplace(glm::vec2(SCR_WIDTH, SCR_HEIGHT));
     if (window == NULL)
     {
@@ -94,6 +145,7 @@ int main()
         return -1;
     }
     glfwMakeContextCurrent(window);
+    glfwSwapInterval(uncapped ? 0 : 1);
 
     // work out how to intergrte this
     Input::input_config config;
@@ -125,27 +177,47 @@ int main()
 
     game_init(window);
     fps_counter_init();
+
+    const double tickLength = 1.0 / simTickRate;
+    double accumulator = 0.0;
+    double lastFrame = glfwGetTime();
     // Render loop
     while (!glfwWindowShouldClose(window))
     {
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
+        double currentFrame = glfwGetTime();
+        double frameTime = std::min(currentFrame - lastFrame, MAX_FRAME_TIME);
+        accumulator += frameTime;
         lastFrame = currentFrame;
 
         glfwPollEvents();
 
-        processInput(window);
-
-
+        // Simulate in fixed steps until caught up with real time
+        int ticks = 0;
+        double tickStart = glfwGetTime();
+        deltaTime = static_cast<float>(tickLength);
+        while (accumulator >= tickLength && ticks < MAX_TICKS_PER_FRAME)
+        {
+            Input::begin_tick();
+            processInput(window);
+            game_tick(deltaTime /* seconds */);
+            Input::end_tick();
+            accumulator -= tickLength;
+            ticks++;
+        }
+        if (ticks == MAX_TICKS_PER_FRAME)
+            accumulator = std::min(accumulator, tickLength);
+        double tickTime = glfwGetTime() - tickStart;
+
+        double renderStart = glfwGetTime();
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        game_update(deltaTime /* seconds */);
+        game_render(static_cast<float>(accumulator / tickLength), static_cast<float>(frameTime));
+        // Frame edges (F9, editor keys) clear here; tick edges clear per tick
         Input::update();
+        double renderTime = glfwGetTime() - renderStart;
 
         glfwSwapBuffers(window);
-        fps_counter_update();
-
-
+        fps_counter_update(ticks, tickTime, renderTime);
     }
 
     glfwTerminate();
@@ -1,6 +1,57 @@
 #include "model_setup.hpp"
+#include "resource_ids.hpp"
 #include <vector>
 
+// Each kind of texture has its own unit, set on every variant when it is built
+static constexpr int DIFFUSE_UNIT = 0;
+static constexpr int SPECULAR_UNIT = 1;
+static constexpr int NORMAL_UNIT = 2;
+
+static unsigned int materialVariants[MATERIAL_VARIANTS];
+
+uint32_t materialFeatures(const Material &material) {
+  uint32_t features = 0;
+  if (material.hasDiffuseTexture != 0)
+    features |= MATERIAL_DIFFUSE_TEXTURE;
+  if (material.hasSpecularTexture != 0)
+    features |= MATERIAL_SPECULAR_TEXTURE;
+  if (material.hasNormalMap != 0)
+    features |= MATERIAL_NORMAL_MAP;
+  return features;
+}
+
+unsigned int materialShader(uint32_t features) {
+  unsigned int &program = materialVariants[features];
+  if (program)
+    return program;
+
+  // The main shader is the variant without textures
+  unsigned int mainShader = entt::locator<Shaders>::value().MAIN;
+  if (features == 0)
+    return program = mainShader;
+
+  std::string defines;
+  if (features & MATERIAL_DIFFUSE_TEXTURE)
+    defines += "#define HAS_DIFFUSE_TEXTURE\n";
+  if (features & MATERIAL_SPECULAR_TEXTURE)
+    defines += "#define HAS_SPECULAR_TEXTURE\n";
+  if (features & MATERIAL_NORMAL_MAP)
+    defines += "#define HAS_NORMAL_MAP\n";
+  program = Shader::Create(resources::path(resources::Shaders_vertex),
+                           resources::path(resources::Shaders_fragment), defines);
+
+  Shader::CopyUniforms(mainShader, program);
+  GLint current = 0;
+  glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+  Shader::Use(program);
+  Shader::SetInt("material_diffuse", program, DIFFUSE_UNIT);
+  Shader::SetInt("material_specular", program, SPECULAR_UNIT);
+  Shader::SetInt("material_normalMap", program, NORMAL_UNIT);
+  Shader::Use(current);
+  return program;
+}
+
+// shader is the material's variant, so only the textures it samples are bound
 static void bindMaterial(Material &material, unsigned int shader) {
 
   Shader::SetVec3("diffuseColor", shader, material.diffuse_color);
@@ -9,34 +60,18 @@ static void bindMaterial(Material &material, unsigned int shader) {
   Shader::SetFloat("metallic", shader, material.metallic);
   Shader::SetFloat("alpha", shader, material.alpha);
   Shader::SetFloat("shininess", shader, material.shininess);
-  Shader::SetInt("hasDiffuseTexture", shader, material.hasDiffuseTexture);
-  Shader::SetInt("hasSpecularTexture", shader, material.hasSpecularTexture);
-  Shader::SetInt("hasNormalMap", shader, material.hasNormalMap);
-
-  int textureUnit = 0;
 
-  // Bind diffuse texture
   if (material.hasDiffuseTexture != 0) {
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glActiveTexture(GL_TEXTURE0 + DIFFUSE_UNIT);
     glBindTexture(GL_TEXTURE_2D, material.diffuse_texture);
-    Shader::SetInt("material_diffuse", shader, textureUnit);
-    textureUnit++;
   }
-
-  // Bind specular texture
-  if (material.specular_texture != 0) {
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
+  if (material.hasSpecularTexture != 0) {
+    glActiveTexture(GL_TEXTURE0 + SPECULAR_UNIT);
     glBindTexture(GL_TEXTURE_2D, material.specular_texture);
-    Shader::SetInt("material_specular", shader, textureUnit);
-    textureUnit++;
   }
-
-  // Bind normal texture
-  if (material.normal_texture != 0) {
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
+  if (material.hasNormalMap != 0) {
+    glActiveTexture(GL_TEXTURE0 + NORMAL_UNIT);
     glBindTexture(GL_TEXTURE_2D, material.normal_texture);
-    Shader::SetInt("material_normalMap", shader, textureUnit);
-    textureUnit++;
   }
 }
 
@@ -123,30 +158,14 @@ void uploadInstanceData(Model *model, std::vector<glm::mat4> instances) {
   glBufferSubData(GL_ARRAY_BUFFER, 0, dataSize, instances.data());
 }
 
-void drawModel(
-    unsigned int shader, Model *model,
-    unsigned int instanceCount) { // if(visibleInstances.empty()) return;
-
-  // Shader::use(shader); // should already be in use
-  int materialIndex = -1;
-
-  for (size_t i = 0; i < model->meshes.size(); i++) {
-
-    const Mesh &mesh = model->meshes[i];
-    // if(materialIndex != mesh.material_index)
-    // {
-        Material &material = model->materials[mesh.material_index];
-        bindMaterial(material, shader);
-        materialIndex =mesh.material_index;
-    // }
-    // Draw this mesh with all instances
-    glBindVertexArray(mesh.VAO);
-    glDrawElementsInstanced(GL_TRIANGLES,
-                            static_cast<GLsizei>(mesh.indices.size()),
-                            GL_UNSIGNED_INT, 0, instanceCount);
-  }
-
-  glBindVertexArray(0);
+void drawMesh(unsigned int shader, Model *model, size_t meshIndex,
+              unsigned int instanceCount) {
+  const Mesh &mesh = model->meshes[meshIndex];
+  bindMaterial(model->materials[mesh.material_index], shader);
+  glBindVertexArray(mesh.VAO);
+  glDrawElementsInstanced(GL_TRIANGLES,
+                          static_cast<GLsizei>(mesh.indices.size()),
+                          GL_UNSIGNED_INT, 0, instanceCount);
 }
 
 // TODO: Can we sort meshes by material?
@@ -16,7 +16,23 @@
 #include <sstream>
 #include <memory>
 
-void drawModel(unsigned int shader, Model *model, unsigned int instanceCount);
+// Textures a material can have. Each combination draws with its own build
+// of the main shader, with the paths for the missing ones compiled out.
+enum MaterialFeature : uint32_t {
+  MATERIAL_DIFFUSE_TEXTURE = 1 << 0,
+  MATERIAL_SPECULAR_TEXTURE = 1 << 1,
+  MATERIAL_NORMAL_MAP = 1 << 2,
+};
+constexpr uint32_t MATERIAL_VARIANTS = 1 << 3;
+
+uint32_t materialFeatures(const Material &material);
+// The main shader built for features, compiled on first use and starting
+// with the uniform values (the lights) set on the main shader
+unsigned int materialShader(uint32_t features);
+// Draws one mesh with its material; shader is
+// materialShader(materialFeatures(material)), already in use
+void drawMesh(unsigned int shader, Model *model, size_t meshIndex,
+              unsigned int instanceCount);
 void uploadInstanceData(Model *model, std::vector<glm::mat4> instances);
 void setupModel(Model *model, int maxInstances);
 void uploadData(Model*model, glm::mat4 transform);
@@ -0,0 +1,153 @@
+#include "narrowphase.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Gap kept between the capsule and a box after a sweep, so the next
+// query starts just outside instead of exactly touching
+static constexpr float SWEEP_SKIN = 1e-3f;
+static constexpr int SWEEP_MAX_ITERATIONS = 32;
+
+OBB OBB::fromTransform(const glm::mat4& matrix, float halfExtent) {
+    OBB box;
+    box.center = glm::vec3(matrix[3]);
+    for (int i = 0; i < 3; i++) {
+        glm::vec3 column(matrix[i]);
+        float length = glm::length(column);
+        box.axes[i] = length > 0.0f ? column / length : glm::vec3(i == 0, i == 1, i == 2);
+        box.halfExtents[i] = length * halfExtent;
+    }
+    return box;
+}
+
+glm::vec3 OBB::toLocal(const glm::vec3& p) const {
+    glm::vec3 d = p - center;
+    return glm::vec3(glm::dot(d, axes[0]), glm::dot(d, axes[1]), glm::dot(d, axes[2]));
+}
+
+glm::vec3 OBB::toWorld(const glm::vec3& local) const {
+    return center + axes[0] * local.x + axes[1] * local.y + axes[2] * local.z;
+}
+
+float segment_obb_distance_sq(const glm::vec3& a, const glm::vec3& b, const OBB& box,
+                              glm::vec3& onSegment, glm::vec3& onBox) {
+    glm::vec3 A = box.toLocal(a);
+    glm::vec3 D = box.toLocal(b) - A;
+    const glm::vec3& h = box.halfExtents;
+
+    // Parameters where the segment enters or leaves a slab, plus the ends
+    float breaks[8];
+    int breakCount = 0;
+    breaks[breakCount++] = 0.0f;
+    breaks[breakCount++] = 1.0f;
+    for (int i = 0; i < 3; i++) {
+        if (std::fabs(D[i]) < 1e-12f) continue;
+        for (float side : {-h[i], h[i]}) {
+            float s = (side - A[i]) / D[i];
+            if (s > 0.0f && s < 1.0f) breaks[breakCount++] = s;
+        }
+    }
+    for (int k = 1; k < breakCount; k++) {
+        for (int j = k; j > 0 && breaks[j] < breaks[j - 1]; j--) std::swap(breaks[j], breaks[j - 1]);
+    }
+
+    float bestDistSq = INFINITY;
+    glm::vec3 bestPoint(0.0f), bestClamped(0.0f);
+    for (int k = 0; k + 1 < breakCount; k++) {
+        float s0 = breaks[k];
+        float s1 = breaks[k + 1];
+        float mid = 0.5f * (s0 + s1);
+
+        // Inside one piece every axis is either in its slab or clamped to a
+        // fixed face, so the squared distance is a quadratic in s
+        float alpha = 0.0f;
+        float beta = 0.0f;
+        for (int i = 0; i < 3; i++) {
+            float p = A[i] + mid * D[i];
+            float face = p > h[i] ? h[i] : (p < -h[i] ? -h[i] : p);
+            if (face == p) continue;
+            alpha += D[i] * D[i];
+            beta += D[i] * (A[i] - face);
+        }
+
+        float s = alpha > 0.0f ? std::clamp(-beta / alpha, s0, s1) : s0;
+        glm::vec3 point = A + D * s;
+        glm::vec3 clamped = glm::clamp(point, -h, h);
+        glm::vec3 diff = point - clamped;
+        float distSq = glm::dot(diff, diff);
+        if (distSq < bestDistSq) {
+            bestDistSq = distSq;
+            bestPoint = point;
+            bestClamped = clamped;
+        }
+    }
+
+    onSegment = box.toWorld(bestPoint);
+    onBox = box.toWorld(bestClamped);
+    return bestDistSq;
+}
+
+bool capsule_obb_contact(const Capsule& capsule, const OBB& box, Contact& contact) {
+    glm::vec3 onSegment, onBox;
+    float distSq = segment_obb_distance_sq(capsule.a, capsule.b, box, onSegment, onBox);
+    if (distSq >= capsule.radius * capsule.radius) return false;
+
+    if (distSq > 1e-12f) {
+        float dist = std::sqrt(distSq);
+        contact.normal = (onSegment - onBox) / dist;
+        contact.depth = capsule.radius - dist;
+        return true;
+    }
+
+    // Segment reaches inside the box: push out through the cheapest face
+    glm::vec3 la = box.toLocal(capsule.a);
+    glm::vec3 lb = box.toLocal(capsule.b);
+    float bestDepth = INFINITY;
+    for (int i = 0; i < 3; i++) {
+        float positive = box.halfExtents[i] + capsule.radius - std::min(la[i], lb[i]);
+        float negative = box.halfExtents[i] + capsule.radius + std::max(la[i], lb[i]);
+        if (positive < bestDepth) {
+            bestDepth = positive;
+            contact.normal = box.axes[i];
+        }
+        if (negative < bestDepth) {
+            bestDepth = negative;
+            contact.normal = -box.axes[i];
+        }
+    }
+    contact.depth = bestDepth;
+    return true;
+}
+
+bool sweep_capsule_obb(const Capsule& capsule, const glm::vec3& delta, const OBB& box, SweepHit& hit) {
+    float speed = glm::length(delta);
+    float t = 0.0f;
+
+    for (int iteration = 0; iteration < SWEEP_MAX_ITERATIONS; iteration++) {
+        glm::vec3 offset = delta * t;
+        glm::vec3 onSegment, onBox;
+        float distSq = segment_obb_distance_sq(capsule.a + offset, capsule.b + offset, box, onSegment, onBox);
+        float gap = std::sqrt(distSq) - capsule.radius;
+
+        if (distSq > 1e-12f) {
+            hit.normal = (onSegment - onBox) / std::sqrt(distSq);
+        } else {
+            hit.normal = speed > 0.0f ? -delta / speed : box.axes[1];
+        }
+
+        if (gap <= SWEEP_SKIN) {
+            // Moving away from a box we already touch is not a hit
+            if (glm::dot(hit.normal, delta) >= 0.0f && t == 0.0f) return false;
+            hit.t = t;
+            return true;
+        }
+
+        if (speed <= 0.0f) return false;
+        t += (gap - 0.5f * SWEEP_SKIN) / speed;
+        if (t > 1.0f) return false;
+    }
+
+    // Still closing in after the iteration budget (grazing approach): every
+    // step so far was safe, so stop here rather than report a miss
+    hit.t = t;
+    return true;
+}
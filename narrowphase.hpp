@@ -0,0 +1,49 @@
+#pragma once
+#include "model.hpp"
+
+// Oriented box: centre, orthonormal axes and half extents along them
+struct OBB {
+    glm::vec3 center;
+    glm::vec3 axes[3];
+    glm::vec3 halfExtents;
+
+    // Box obtained by applying an affine (rotation + scale + translation)
+    // matrix to the cube [-halfExtent, halfExtent]^3
+    static OBB fromTransform(const glm::mat4& matrix, float halfExtent);
+
+    glm::vec3 toLocal(const glm::vec3& p) const;
+    glm::vec3 toWorld(const glm::vec3& local) const;
+};
+
+// Segment a-b swept by a sphere of the given radius. A sphere is a capsule
+// with a == b.
+struct Capsule {
+    glm::vec3 a;
+    glm::vec3 b;
+    float radius;
+};
+
+struct Contact {
+    glm::vec3 normal; // points from the box towards the capsule
+    float depth;      // penetration, > 0 when overlapping
+};
+
+struct SweepHit {
+    float t;          // fraction of the motion travelled before touching
+    glm::vec3 normal; // contact normal at time of impact
+};
+
+// Squared distance between a segment and a box, with the closest points.
+// Exact: the distance along the segment is a piecewise quadratic whose
+// pieces change only where the segment crosses one of the slab planes.
+float segment_obb_distance_sq(const glm::vec3& a, const glm::vec3& b, const OBB& box,
+                              glm::vec3& onSegment, glm::vec3& onBox);
+
+// Overlap test with contact generation. Deep overlaps (segment inside the
+// box) are resolved along the face axis needing the smallest push.
+bool capsule_obb_contact(const Capsule& capsule, const OBB& box, Contact& contact);
+
+// Time of impact of capsule moving by delta, found by conservative
+// advancement: the gap can shrink by at most |delta| per unit t, so
+// stepping by gap / |delta| never steps through the box.
+bool sweep_capsule_obb(const Capsule& capsule, const glm::vec3& delta, const OBB& box, SweepHit& hit);
@@ -0,0 +1,159 @@
+#include "particle_collision.hpp"
+#include "collider_store.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Bounced particles are left this far outside the surface
+static constexpr float SURFACE_OFFSET = 1e-3f;
+
+void ParticleColliders::gather(ColliderStore& colliders, const AABB& region) {
+    nearby.clear();
+    colliders.query(region, nearby);
+
+    bounds.resize(0);
+    boxes.clear();
+    store = nullptr;
+    if (nearby.size() > MAX_BATCHED) {
+        store = &colliders;
+        return;
+    }
+
+    bounds.resize(nearby.size());
+    for (size_t i = 0; i < nearby.size(); i++) {
+        bounds.set(i, colliders.getBounds(nearby[i]));
+        boxes.push_back(colliders.getOBB(nearby[i]));
+    }
+}
+
+// Segment from -> to against one box. On a hit, applies the response and
+// returns true; to, velocity and life are updated in place.
+static bool collide_particle(const OBB& box, const ParticleEmitterConfig& config, const glm::vec3& from,
+                             glm::vec3& to, glm::vec3& velocity, float& life) {
+    const glm::vec3 a = box.toLocal(from);
+    const glm::vec3 d = box.toLocal(to) - a;
+    const glm::vec3& h = box.halfExtents;
+
+    // Slab test: the latest slab entry is where the segment enters the box
+    float enter = -INFINITY, leave = INFINITY;
+    int axis = -1;
+    for (int i = 0; i < 3; i++) {
+        if (std::abs(d[i]) < 1e-9f) {
+            if (std::abs(a[i]) > h[i]) return false;
+            continue;
+        }
+        float t0 = (-h[i] - a[i]) / d[i];
+        float t1 = (h[i] - a[i]) / d[i];
+        if (t0 > t1) std::swap(t0, t1);
+        if (t0 > enter) {
+            enter = t0;
+            axis = i;
+        }
+        leave = std::min(leave, t1);
+    }
+    if (enter > leave || leave < 0.0f || enter > 1.0f) return false;
+
+    glm::vec3 contact;
+    float side;
+    if (enter >= 0.0f && axis >= 0) {
+        contact = a + d * enter;
+        side = d[axis] > 0.0f ? -1.0f : 1.0f;
+    } else {
+        // Started inside (spawned in a wall): out through the nearest face
+        axis = 0;
+        for (int i = 1; i < 3; i++) {
+            if (h[i] - std::abs(a[i]) < h[axis] - std::abs(a[axis])) axis = i;
+        }
+        contact = a;
+        side = a[axis] >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    if (config.collision == ParticleCollision::Kill) {
+        life = 0.0f;
+        return true;
+    }
+
+    contact[axis] = side * (h[axis] + SURFACE_OFFSET);
+    to = box.toWorld(contact);
+
+    const glm::vec3 normal = box.axes[axis] * side;
+    float into = glm::dot(velocity, normal);
+    if (into < 0.0f) {
+        glm::vec3 tangent = velocity - normal * into;
+        velocity = tangent * (1.0f - config.friction) - normal * (into * config.restitution);
+    }
+    return true;
+}
+
+void particles_collide(ParticleColliders& colliders, const ParticleEmitterConfig& config,
+                       const simd::f32x4 old[3], simd::f32x4 position[3], simd::f32x4 velocity[3],
+                       simd::f32x4& life, int valid) {
+    using namespace simd;
+
+    // Lanes are spilled to scalars only for the particles that need the
+    // exact test, then loaded back
+    float o[3][4], p[3][4], v[3][4], l[4];
+    bool spilled = false;
+    auto spill = [&]() {
+        if (spilled) return;
+        for (int axis = 0; axis < 3; axis++) {
+            store(o[axis], old[axis]);
+            store(p[axis], position[axis]);
+            store(v[axis], velocity[axis]);
+        }
+        store(l, life);
+        spilled = true;
+    };
+    auto resolve = [&](int lane, const OBB& box) {
+        glm::vec3 from(o[0][lane], o[1][lane], o[2][lane]);
+        glm::vec3 to(p[0][lane], p[1][lane], p[2][lane]);
+        glm::vec3 vel(v[0][lane], v[1][lane], v[2][lane]);
+        if (!collide_particle(box, config, from, to, vel, l[lane])) return;
+        for (int axis = 0; axis < 3; axis++) {
+            p[axis][lane] = to[axis];
+            v[axis][lane] = vel[axis];
+        }
+    };
+
+    if (colliders.store) {
+        spill();
+        for (int lane = 0; lane < 4; lane++) {
+            if (!(valid & (1 << lane)) || l[lane] <= 0.0f) continue;
+            glm::vec3 from(o[0][lane], o[1][lane], o[2][lane]);
+            glm::vec3 to(p[0][lane], p[1][lane], p[2][lane]);
+            colliders.nearby.clear();
+            colliders.store->query(AABB(glm::min(from, to), glm::max(from, to)), colliders.nearby);
+            for (uint32_t index : colliders.nearby) resolve(lane, colliders.store->getOBB(index));
+        }
+    } else {
+        const BoundsSoA& bounds = colliders.bounds;
+        for (size_t c = 0; c < colliders.boxes.size(); c++) {
+            // Motion box of each lane, against the collider's bounds. After
+            // a bounce the lanes are reloaded, so later colliders see it.
+            f32x4 lo[3], hi[3];
+            for (int axis = 0; axis < 3; axis++) {
+                f32x4 now = spilled ? load(p[axis]) : position[axis];
+                lo[axis] = min(old[axis], now);
+                hi[axis] = max(old[axis], now);
+            }
+            f32x4 miss = bit_or(bit_or(cmplt(hi[0], set1(bounds.minX[c])), cmplt(set1(bounds.maxX[c]), lo[0])),
+                                bit_or(bit_or(cmplt(hi[1], set1(bounds.minY[c])), cmplt(set1(bounds.maxY[c]), lo[1])),
+                                       bit_or(cmplt(hi[2], set1(bounds.minZ[c])), cmplt(set1(bounds.maxZ[c]), lo[2]))));
+            int hits = ~movemask(miss) & valid;
+            if (!hits) continue;
+
+            spill();
+            while (hits) {
+                int lane = __builtin_ctz(hits);
+                hits &= hits - 1;
+                if (l[lane] > 0.0f) resolve(lane, colliders.boxes[c]);
+            }
+        }
+    }
+
+    if (!spilled) return;
+    for (int axis = 0; axis < 3; axis++) {
+        position[axis] = load(p[axis]);
+        velocity[axis] = load(v[axis]);
+    }
+    life = load(l);
+}
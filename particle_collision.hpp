@@ -0,0 +1,38 @@
+#pragma once
+#include "bounds.hpp"
+#include "narrowphase.hpp"
+#include "particle_simulation.hpp"
+#include "simd.hpp"
+#include <cstdint>
+#include <vector>
+
+class ColliderStore;
+
+// Static colliders near one emitter, gathered from the ColliderStore grid
+// before its update. A handful of candidates are tested four particles at
+// a time: a SIMD reject of each particle's motion box against each
+// candidate's bounds, with the exact segment test only for lanes that
+// pass. Past MAX_BATCHED candidates, testing every particle against all of
+// them would cost more than asking the grid per particle, so the batch
+// is dropped and each particle queries the cells its motion covers.
+struct ParticleColliders {
+    static constexpr size_t MAX_BATCHED = 16;
+
+    BoundsSoA bounds;
+    std::vector<OBB> boxes;
+    ColliderStore* store = nullptr; // set when falling back to per-particle queries
+    std::vector<uint32_t> nearby;   // scratch for those queries
+
+    // Candidates overlapping region, the space the emitter's particles can
+    // reach this update
+    void gather(ColliderStore& colliders, const AABB& region);
+    bool empty() const { return boxes.empty() && !store; }
+};
+
+// Moves particles from old to new positions through the colliders and
+// applies the config's response to the lanes that hit something: Bounce
+// puts them back on the surface and reflects their velocity, Kill zeroes
+// their life. valid masks the lanes in use.
+void particles_collide(ParticleColliders& colliders, const ParticleEmitterConfig& config,
+                       const simd::f32x4 old[3], simd::f32x4 position[3], simd::f32x4 velocity[3],
+                       simd::f32x4& life, int valid);
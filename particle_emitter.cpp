@@ -1,78 +1,15 @@
 #include "particle_emitter.hpp"
+#include "collider_store.hpp"
 #include <algorithm>
 #include <cmath>
 
-ParticleEmitter::ParticleEmitter(const ParticleEmitterConfig& cfg)
-    : config(cfg), gen(rd()), dis(0.0f, 1.0f) {
-    particles.reserve(config.maxParticles);
-    instanceData.reserve(config.maxParticles);
-    setupBuffers();
+ParticleEmitter::ParticleEmitter(const ParticleEmitterConfig& cfg, ParticleInstanceData* instances, size_t capacity)
+    : config(cfg), rng(cfg.seed ? cfg.seed : std::random_device{}()), instances(instances), slots(capacity) {
+    // GPU emitters keep their particles in the manager's buffers
+    if (config.backend == ParticleBackend::Cpu) particles.reserve(capacity);
 }
 
-ParticleEmitter::~ParticleEmitter() {
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &instanceVBO);
-    glDeleteVertexArrays(1, &VAO);
-}
-
-void ParticleEmitter::setupBuffers() {
-    // Create quad vertices for billboarded particles
-    ParticleVertex vertices[] = {
-        {{ -0.5f, -0.5f, 0.0f }, { 0.0f, 0.0f }},
-        {{  0.5f, -0.5f, 0.0f }, { 1.0f, 0.0f }},
-        {{  0.5f,  0.5f, 0.0f }, { 1.0f, 1.0f }},
-        {{ -0.5f,  0.5f, 0.0f }, { 0.0f, 1.0f }}
-    };
-
-    GLuint indices[] = { 0, 1, 2, 2, 3, 0 };
-
-    GLuint EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-    glGenBuffers(1, &instanceVBO);
-
-    glBindVertexArray(VAO);
-
-    // Setup vertex data
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    // Vertex attributes (per-vertex data)
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex), (void*)0);
-
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex), (void*)offsetof(ParticleVertex, texCoord));
-
-    // Setup instance buffer
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    glBufferData(GL_ARRAY_BUFFER, config.maxParticles * sizeof(ParticleInstanceData), nullptr, GL_DYNAMIC_DRAW);
-
-    // Instance attributes (per-instance data)
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(ParticleInstanceData), (void*)0);
-    glVertexAttribDivisor(2, 1);
-
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstanceData), (void*)offsetof(ParticleInstanceData, color));
-    glVertexAttribDivisor(3, 1);
-
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(ParticleInstanceData), (void*)offsetof(ParticleInstanceData, size));
-    glVertexAttribDivisor(4, 1);
-
-    glEnableVertexAttribArray(5);
-    glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(ParticleInstanceData), (void*)offsetof(ParticleInstanceData, rotation));
-    glVertexAttribDivisor(5, 1);
-
-    glBindVertexArray(0);
-}
-
-void ParticleEmitter::update(float deltaTime) {
+void ParticleEmitter::update(float deltaTime, ColliderStore* store) {
     systemTime += deltaTime;
 
     // Check if we should stop emitting (for non-looping emitters)
@@ -80,107 +17,131 @@ void ParticleEmitter::update(float deltaTime) {
         isActive = false;
     }
 
+    const float rate = config.emissionRate * emissionScale;
+    if (config.backend == ParticleBackend::Gpu) {
+        updateGpuEmission(deltaTime, rate);
+        return;
+    }
+
     // Emit new particles
-    if (isActive && particles.size() < config.maxParticles) {
+    if (isActive && particles.count < particles.capacity()) {
         emissionTimer += deltaTime;
-        float emissionInterval = 1.0f / config.emissionRate;
+        float emissionInterval = 1.0f / rate;
 
-        while (emissionTimer >= emissionInterval && particles.size() < config.maxParticles) {
-            spawnParticle();
-            emissionTimer -= emissionInterval;
-        }
+        // Everything due this frame in one batch
+        size_t due = static_cast<size_t>(emissionTimer / emissionInterval);
+        size_t spawned = particles_spawn(particles, config, due, rng);
+        emissionTimer -= spawned * emissionInterval;
     }
 
-    // Update existing particles
-    for (auto it = particles.begin(); it != particles.end();) {
-        Particle& p = *it;
+    // The bounds cover everywhere a particle can get to, so every
+    // collider a particle can reach this update is among the candidates
+    ParticleColliders* nearby = nullptr;
+    if (store && store->size() > 0 && config.collision != ParticleCollision::None) {
+        colliders.gather(*store, getBounds());
+        nearby = &colliders;
+    }
 
-        // Update physics
-        p.velocity += config.gravity * deltaTime;
-        p.velocity *= config.damping;
-        p.position += p.velocity * deltaTime;
-        p.rotation += p.rotationSpeed * deltaTime;
+    // Integrate, collide, drop the dead and build instances in one pass
+    if (sizeScale == 1.0f) {
+        instanceCount = particles_update(particles, config, deltaTime, instances, nearby);
+    } else {
+        ParticleEmitterConfig scaled = config;
+        scaled.startSize *= sizeScale;
+        scaled.endSize *= sizeScale;
+        instanceCount = particles_update(particles, scaled, deltaTime, instances, nearby);
+    }
+}
 
-        // Update life
-        p.life -= deltaTime;
+void ParticleEmitter::fastForward(float deltaTime, float step) {
+    if (!canFastForward() || deltaTime <= 0.0f) return;
 
-        if (p.life <= 0.0f) {
-            it = particles.erase(it);
-        } else {
-            ++it;
-        }
+    particles_fast_forward(particles, config, deltaTime, step);
+    instanceCount = 0;
+
+    // Emission runs until the end of the window, or a one-shot's duration
+    float start = systemTime;
+    bool wasActive = isActive;
+    systemTime += deltaTime;
+    if (!config.looping && systemTime >= config.duration) isActive = false;
+    if (!wasActive) return;
+
+    float emitting = config.looping ? deltaTime : std::clamp(config.duration - start, 0.0f, deltaTime);
+    float rate = config.emissionRate * emissionScale;
+
+    // Only emission in the last lifetime of the window can still be alive
+    float oldest = deltaTime;
+    float youngest = deltaTime - emitting;
+    float cutoff = std::min(oldest, getMaxLifetime());
+    if (cutoff > youngest) {
+        size_t due = static_cast<size_t>((cutoff - youngest) * rate);
+        particles_spawn_aged(particles, config, due, youngest, cutoff, step, rng);
     }
+    emissionTimer = std::fmod(emissionTimer + emitting, 1.0f / rate);
+}
 
-    // Prepare instance data for rendering
-    instanceData.clear();
-    for (const auto& particle : particles) {
-        float lifeRatio = particle.life / config.particleLifetime;
+// Only the timing lives here; the spawns are handed to the GPU step
+void ParticleEmitter::updateGpuEmission(float deltaTime, float rate) {
+    if (!isActive) return;
 
-        ParticleInstanceData data;
-        data.worldPosition = particle.position;
-        data.color = glm::mix(config.endColor, config.startColor, lifeRatio);
-        data.size = glm::mix(config.endSize, config.startSize, lifeRatio) * particle.size;
-        data.rotation = particle.rotation;
+    emissionTimer += deltaTime;
+    float emissionInterval = 1.0f / rate;
+    size_t due = std::min(static_cast<size_t>(emissionTimer / emissionInterval), slots);
+    emissionTimer -= due * emissionInterval;
 
-        instanceData.push_back(data);
+    if (due > 0) {
+        pendingSpawns += due;
+        gpuSpawned = std::min(gpuSpawned + due, slots);
+        lastSpawnTime = systemTime;
     }
 }
 
-void ParticleEmitter::render(GLuint shaderProgram, const glm::mat4& view, const glm::mat4& projection) {
-    if (instanceData.empty()) return;
+size_t ParticleEmitter::takeSpawnRequest() {
+    size_t due = std::min(pendingSpawns, slots);
+    pendingSpawns = 0;
+    return due;
+}
 
-    glUseProgram(shaderProgram);
+uint32_t ParticleEmitter::nextSeed() {
+    return static_cast<uint32_t>(rng.next() * 16777216.0f) ^ (++seedCounter << 24);
+}
 
-    // Upload matrices
-    GLint viewLoc = glGetUniformLocation(shaderProgram, "view");
-    GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, &view[0][0]);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, &projection[0][0]);
+bool ParticleEmitter::isAlive() const {
+    if (config.backend == ParticleBackend::Gpu) {
+        // No read back, so go by the longest a spawned particle can live
+        return isActive || systemTime - lastSpawnTime < config.particleLifetime + config.lifetimeVariance;
+    }
+    return isActive || particles.count > 0;
+}
 
-    // Upload instance data
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, instanceData.size() * sizeof(ParticleInstanceData), instanceData.data());
+int ParticleEmitter::getParticleCount() const {
+    if (config.backend == ParticleBackend::Gpu) return isAlive() ? static_cast<int>(gpuSpawned) : 0;
+    return static_cast<int>(particles.count);
+}
 
-    // Render
-    glBindVertexArray(VAO);
-    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, instanceData.size());
-    glBindVertexArray(0);
+AABB ParticleEmitter::getBounds() const {
+    const float lifetime = getMaxLifetime();
+    const glm::vec3 fall = 0.5f * config.gravity * lifetime * lifetime;
+    const glm::vec3 slowest = config.initialVelocity - config.velocityVariance;
+    const glm::vec3 fastest = config.initialVelocity + config.velocityVariance;
+    const float size = std::max(config.startSize, config.endSize) + config.sizeVariance;
+
+    glm::vec3 low = config.spawnPosition - config.spawnPositionVariance +
+                    glm::min(slowest * lifetime, glm::vec3(0.0f)) + glm::min(fall, glm::vec3(0.0f));
+    glm::vec3 high = config.spawnPosition + config.spawnPositionVariance +
+                     glm::max(fastest * lifetime, glm::vec3(0.0f)) + glm::max(fall, glm::vec3(0.0f));
+    return AABB(low - glm::vec3(size), high + glm::vec3(size));
 }
 
 void ParticleEmitter::reset() {
     particles.clear();
-    instanceData.clear();
+    instanceCount = 0;
+    pendingSpawns = 0;
     emissionTimer = 0.0f;
     systemTime = 0.0f;
     isActive = true;
 }
 
-void ParticleEmitter::spawnParticle() {
-    Particle p;
-
-    p.position = randomVec3(config.spawnPosition, config.spawnPositionVariance);
-    p.velocity = randomVec3(config.initialVelocity, config.velocityVariance);
-    p.life = config.particleLifetime + randomFloat(-config.lifetimeVariance, config.lifetimeVariance);
-    p.size = config.startSize + randomFloat(-config.sizeVariance, config.sizeVariance);
-    p.rotation = randomFloat(0.0f, 2.0f * M_PI);
-    p.rotationSpeed = config.rotationSpeed + randomFloat(-config.rotationVariance, config.rotationVariance);
-    p.color = config.startColor;
-
-    particles.push_back(p);
-}
-
-float ParticleEmitter::randomFloat(float min, float max) {
-    return min + dis(gen) * (max - min);
-}
-
-glm::vec3 ParticleEmitter::randomVec3(const glm::vec3& base, const glm::vec3& variance) {
-    return glm::vec3(
-        base.x + randomFloat(-variance.x, variance.x),
-        base.y + randomFloat(-variance.y, variance.y),
-        base.z + randomFloat(-variance.z, variance.z)
-    );
-}
-
 // Preset implementations
 namespace ParticlePresets {
     ParticleEmitterConfig createFire() {
@@ -197,6 +158,7 @@ namespace ParticlePresets {
         config.endColor = glm::vec4(1.0f, 0.2f, 0.0f, 0.0f);
         config.gravity = glm::vec3(0.0f, 1.0f, 0.0f);
         config.damping = 0.95f;
+        config.blend = ParticleBlend::Additive;
         return config;
     }
 
@@ -233,6 +195,9 @@ namespace ParticlePresets {
         config.damping = 0.98f;
         config.looping = false;
         config.duration = 0.5f;
+        config.blend = ParticleBlend::Additive;
+        config.collision = ParticleCollision::Bounce;
+        config.restitution = 0.5f;
         return config;
     }
 
@@ -251,6 +216,7 @@ namespace ParticlePresets {
         config.endColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
         config.gravity = glm::vec3(0.0f, -2.0f, 0.0f);
         config.damping = 1.0f;
+        config.backend = ParticleBackend::Gpu;
         return config;
     }
 
@@ -270,6 +236,8 @@ namespace ParticlePresets {
         config.damping = 0.95f;
         config.looping = false;
         config.duration = 0.1f;
+        config.blend = ParticleBlend::Additive;
+        config.collision = ParticleCollision::Kill;
         return config;
     }
 }
@@ -1,108 +1,75 @@
 #pragma once
-#include "mygl.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include "model.hpp"
+#include "particle_collision.hpp"
+#include "particle_simulation.hpp"
 #include <vector>
 #include <random>
 
-struct Particle {
-    glm::vec3 position;
-    glm::vec3 velocity;
-    glm::vec4 color;
-    float life;
-    float size;
-    float rotation;
-    float rotationSpeed;
-};
-
-struct ParticleEmitterConfig {
-    // Emission
-    float emissionRate = 50.0f;  // particles per second
-    int maxParticles = 1000;
-
-    // Spawn properties
-    glm::vec3 spawnPosition = glm::vec3(0.0f);
-    glm::vec3 spawnPositionVariance = glm::vec3(0.1f);
-    glm::vec3 initialVelocity = glm::vec3(0.0f, 1.0f, 0.0f);
-    glm::vec3 velocityVariance = glm::vec3(0.5f);
-
-    // Particle properties
-    float particleLifetime = 2.0f;
-    float lifetimeVariance = 0.5f;
-    float startSize = 0.1f;
-    float endSize = 0.05f;
-    float sizeVariance = 0.02f;
-
-    // Color over lifetime
-    glm::vec4 startColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-    glm::vec4 endColor = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
-
-    // Physics
-    glm::vec3 gravity = glm::vec3(0.0f, -9.81f, 0.0f);
-    float damping = 0.98f;
-
-    // Rotation
-    float rotationSpeed = 0.0f;
-    float rotationVariance = 1.0f;
-
-    // Simulation
-    bool looping = true;
-    float duration = 5.0f;  // Only used if looping is false
-};
-
+// Simulates one effect. GL resources and the instance storage belong to
+// the ParticleManager, which creates emitters and hands each a slice of
+// its particle budget; update() writes straight into that slice.
 class ParticleEmitter {
 private:
-    std::vector<Particle> particles;
+    ParticleSoA particles;
     ParticleEmitterConfig config;
 
-    // OpenGL resources
-    GLuint VAO, VBO;
-
     // Emission timing
     float emissionTimer = 0.0f;
     float systemTime = 0.0f;
     bool isActive = true;
 
-    // Random number generation
-    std::random_device rd;
-    std::mt19937 gen;
-    std::uniform_real_distribution<float> dis;
-
-    // Vertex data for instanced rendering
-    struct ParticleVertex {
-        glm::vec3 position;
-        glm::vec2 texCoord;
-    };
-
-    // Instance data uploaded to GPU
-    struct ParticleInstanceData {
-        glm::vec3 worldPosition;
-        glm::vec4 color;
-        float size;
-        float rotation;
-    };
-
-    GLuint instanceVBO;
-    std::vector<ParticleInstanceData> instanceData;
-
-    void setupBuffers();
-    void spawnParticle();
-    float randomFloat(float min, float max);
-    glm::vec3 randomVec3(const glm::vec3& base, const glm::vec3& variance);
+    Rng4 rng;
 
-public:
-    ParticleEmitter(const ParticleEmitterConfig& cfg);
-    ~ParticleEmitter();
+    // Colliders near the emitter, regathered every update
+    ParticleColliders colliders;
 
-    void update(float deltaTime);
-    void render(GLuint shaderProgram, const glm::mat4& view, const glm::mat4& projection);
+    // Level of detail, from the manager
+    float emissionScale = 1.0f;
+    float sizeScale = 1.0f;
+
+    // Slice of the manager's instance pool
+    ParticleInstanceData* instances;
+    size_t instanceCount = 0;
+    size_t slots;
+
+    // GPU backend: spawns owed to the next GPU step
+    size_t pendingSpawns = 0;
+    size_t gpuSpawned = 0;
+    float lastSpawnTime = 0.0f;
+    uint32_t seedCounter = 0;
+
+    void updateGpuEmission(float deltaTime, float rate);
+
+public:
+    ParticleEmitter(const ParticleEmitterConfig& cfg, ParticleInstanceData* instances, size_t capacity);
+
+    // With a store, emitters whose config asks for it collide with the
+    // static colliders in it
+    void update(float deltaTime, ColliderStore* store = nullptr);
+
+    // Jumps deltaTime ahead as if updated every step seconds, for emitters
+    // nobody can see: live particles move in closed form and the emission
+    // over deltaTime is spawned at the ages it would have reached. CPU
+    // backend without collision only. Instances are rebuilt by the next
+    // update.
+    void fastForward(float deltaTime, float step);
+    bool canFastForward() const {
+        return config.backend == ParticleBackend::Cpu && config.collision == ParticleCollision::None;
+    }
+
+    // Distance level of detail: multipliers on the emission rate and
+    // particle size, applied from the next update
+    void setDetail(float emission, float size) { emissionScale = emission; sizeScale = size; }
+    float getSizeScale() const { return sizeScale; }
 
     // Control methods
     void start() { isActive = true; systemTime = 0.0f; }
     void stop() { isActive = false; }
     void reset();
 
-    // Configuration
+    // Configuration. The backend is fixed when the emitter is created.
     void setConfig(const ParticleEmitterConfig& cfg) { config = cfg; }
     const ParticleEmitterConfig& getConfig() const { return config; }
 
@@ -111,8 +78,30 @@ public:
     glm::vec3 getPosition() const { return config.spawnPosition; }
 
     // State queries
-    bool isAlive() const { return isActive || !particles.empty(); }
-    int getParticleCount() const { return particles.size(); }
+    // GPU emitters never read back, so their count is the number of
+    // slots spawned so far - an upper bound
+    bool isAlive() const;
+    int getParticleCount() const;
+
+    // Conservative world bounds of anything the config can emit: the spawn
+    // box grown by the farthest a particle can travel in its lifetime, as
+    // if undamped, and by its size. Holds without looking at particles, so
+    // it stays valid while the emitter is not simulated.
+    AABB getBounds() const;
+    float getMaxLifetime() const { return config.particleLifetime + config.lifetimeVariance; }
+    size_t getCapacity() const { return slots; }
+
+    // GPU backend: particles to spawn on the next step, and a fresh seed
+    // for it. Taking the request clears it.
+    size_t takeSpawnRequest();
+    uint32_t nextSeed();
+
+    // Particle k is instance k after an update
+    const ParticleSoA& getParticles() const { return particles; }
+
+    // Instances built by the last update, always empty on the GPU backend
+    const ParticleInstanceData* getInstances() const { return instances; }
+    size_t getInstanceCount() const { return instanceCount; }
 };
 
 // Utility function to create common emitter presets
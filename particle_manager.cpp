@@ -0,0 +1,516 @@
+#include "particle_manager.hpp"
+#include "culling.hpp"
+#include "shader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+struct QuadVertex {
+    glm::vec3 position;
+    glm::vec2 texCoord;
+};
+
+double elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+bool draws_before(GLuint shaderA, ParticleBlend blendA, GLuint shaderB, ParticleBlend blendB) {
+    if (shaderA != shaderB) return shaderA < shaderB;
+    return blendA < blendB;
+}
+
+void apply_blend(ParticleBlend blend) {
+    if (blend == ParticleBlend::Additive) {
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    } else {
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+}
+
+} // namespace
+
+ParticleManager::ParticleManager(size_t budget) : budget(budget) {
+    pool.resize(budget);
+    freeList.push_back({0, budget});
+    stats.budget = budget;
+
+    // Create quad vertices for billboarded particles
+    QuadVertex vertices[] = {
+        {{ -0.5f, -0.5f, 0.0f }, { 0.0f, 0.0f }},
+        {{  0.5f, -0.5f, 0.0f }, { 1.0f, 0.0f }},
+        {{  0.5f,  0.5f, 0.0f }, { 1.0f, 1.0f }},
+        {{ -0.5f,  0.5f, 0.0f }, { 0.0f, 1.0f }}
+    };
+    GLuint indices[] = { 0, 1, 2, 2, 3, 0 };
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &quadVBO);
+    glGenBuffers(1, &quadEBO);
+    glGenBuffers(1, &instanceVBO);
+
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(QuadVertex), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(QuadVertex), (void*)offsetof(QuadVertex, texCoord));
+
+    // Instance attributes; pointers are re-aimed at each group's run in render
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, budget * sizeof(ParticleInstanceData), nullptr, GL_STREAM_DRAW);
+    for (GLuint attribute = 2; attribute <= 5; attribute++) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+    bindInstances(0);
+
+    glBindVertexArray(0);
+}
+
+ParticleManager::~ParticleManager() {
+    glDeleteBuffers(1, &quadVBO);
+    glDeleteBuffers(1, &quadEBO);
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteVertexArrays(1, &VAO);
+    if (gpuProgram.id) glDeleteProgram(gpuProgram.id);
+}
+
+bool ParticleManager::allocate(size_t count, Slice& out) {
+    if (count == 0 || freeList.empty()) return false;
+
+    // First fit, falling back to the largest block when nothing fits
+    auto block = std::find_if(freeList.begin(), freeList.end(), [count](const Slice& s) { return s.size >= count; });
+    if (block == freeList.end()) {
+        block = std::max_element(freeList.begin(), freeList.end(),
+                                 [](const Slice& a, const Slice& b) { return a.size < b.size; });
+        count = block->size;
+    }
+
+    out = {block->offset, count};
+    block->offset += count;
+    block->size -= count;
+    if (block->size == 0) freeList.erase(block);
+    return true;
+}
+
+void ParticleManager::release(Slice slice) {
+    auto next = std::lower_bound(freeList.begin(), freeList.end(), slice.offset,
+                                 [](const Slice& s, size_t offset) { return s.offset < offset; });
+    next = freeList.insert(next, slice);
+
+    // Merge with the following block, then the preceding one
+    if (next + 1 != freeList.end() && next->offset + next->size == (next + 1)->offset) {
+        next->size += (next + 1)->size;
+        freeList.erase(next + 1);
+    }
+    if (next != freeList.begin() && (next - 1)->offset + (next - 1)->size == next->offset) {
+        (next - 1)->size += next->size;
+        freeList.erase(next);
+    }
+}
+
+ParticleEmitter* ParticleManager::createEmitter(const ParticleEmitterConfig& config, GLuint shader) {
+    Slice slice;
+    if (!allocate(static_cast<size_t>(std::max(config.maxParticles, 0)), slice)) {
+        std::cerr << "Particle budget of " << budget << " spent, emitter not created" << std::endl;
+        return nullptr;
+    }
+    if (slice.size < static_cast<size_t>(config.maxParticles)) {
+        std::cerr << "Particle budget low, emitter gets " << slice.size << " of " << config.maxParticles
+                  << " particles" << std::endl;
+    }
+
+    Entry entry;
+    entry.emitter = std::make_unique<ParticleEmitter>(config, pool.data() + slice.offset, slice.size);
+    if (config.backend == ParticleBackend::Gpu) {
+        if (gpuProgram.id == 0) gpuProgram = GpuParticleProgram::create();
+        entry.gpu = std::make_unique<GpuParticleSim>(slice.size, quadVBO, quadEBO);
+    }
+    entry.shader = shader;
+    entry.blend = config.blend;
+    entry.slice = slice;
+
+    auto position = std::upper_bound(entries.begin(), entries.end(), entry, [](const Entry& a, const Entry& b) {
+        return draws_before(a.shader, a.blend, b.shader, b.blend);
+    });
+    ParticleEmitter* emitter = entry.emitter.get();
+    entries.insert(position, std::move(entry));
+    return emitter;
+}
+
+void ParticleManager::destroyEmitter(ParticleEmitter* emitter) {
+    auto it = std::find_if(entries.begin(), entries.end(),
+                           [emitter](const Entry& entry) { return entry.emitter.get() == emitter; });
+    if (it == entries.end()) return;
+    release(it->slice);
+    entries.erase(it);
+}
+
+void ParticleManager::update(float dt) {
+    auto start = std::chrono::steady_clock::now();
+
+    stats.lodFull = 0;
+    stats.lodCoarse = 0;
+    stats.lodSkipped = 0;
+    for (Entry& entry : entries) {
+        auto emitterStart = std::chrono::steady_clock::now();
+        updateEntry(entry, dt);
+        entry.updateMs = elapsed_ms(emitterStart);
+    }
+
+    stats.updateMs = elapsed_ms(start);
+}
+
+void ParticleManager::setView(const glm::vec3& position, const Frustum& viewFrustum) {
+    eye = position;
+    frustum = viewFrustum;
+    hasView = true;
+}
+
+ParticleLod ParticleManager::chooseLod(Entry& entry) const {
+    ParticleEmitter& emitter = *entry.emitter;
+    if (!lodSettings.enabled || !hasView) {
+        emitter.setDetail(1.0f, 1.0f);
+        return ParticleLod::Full;
+    }
+
+    AABB bounds = emitter.getBounds();
+    if (!aabb_in_frustum(bounds, frustum)) {
+        return emitter.canFastForward() ? ParticleLod::Skipped : ParticleLod::Coarse;
+    }
+
+    // Distance to the nearest point of the bounds, zero from inside
+    float distance = glm::length(eye - glm::clamp(eye, bounds.min, bounds.max));
+    float range = std::max(lodSettings.lowDetailDistance - lodSettings.fullDetailDistance, 1e-3f);
+    float t = std::clamp((distance - lodSettings.fullDetailDistance) / range, 0.0f, 1.0f);
+    emitter.setDetail(1.0f + (lodSettings.minEmissionScale - 1.0f) * t, 1.0f + (lodSettings.minSizeScale - 1.0f) * t);
+    return ParticleLod::Full;
+}
+
+void ParticleManager::updateEntry(Entry& entry, float dt) {
+    ParticleEmitter& emitter = *entry.emitter;
+    ParticleLod lod = chooseLod(entry);
+
+    switch (lod) {
+    case ParticleLod::Full: {
+        // Catch up on the time spent out of view first
+        float step = dt;
+        if (entry.lod == ParticleLod::Skipped) {
+            emitter.fastForward(entry.hiddenTime, dt);
+        } else {
+            step += entry.hiddenTime;
+        }
+        entry.hiddenTime = 0.0f;
+        emitter.update(step, &colliderStore);
+        if (entry.gpu) queueGpuStep(entry, step);
+        stats.lodFull++;
+        break;
+    }
+    case ParticleLod::Coarse:
+        entry.hiddenTime += dt;
+        if (entry.hiddenTime >= lodSettings.coarseInterval) {
+            emitter.update(entry.hiddenTime, &colliderStore);
+            if (entry.gpu) queueGpuStep(entry, entry.hiddenTime);
+            entry.hiddenTime = 0.0f;
+        }
+        stats.lodCoarse++;
+        break;
+    case ParticleLod::Skipped:
+        // Past a lifetime every particle has been replaced, so catch up
+        // now and keep isAlive() and the counts from going stale
+        entry.hiddenTime += dt;
+        if (entry.hiddenTime >= emitter.getMaxLifetime()) {
+            emitter.fastForward(entry.hiddenTime, dt);
+            entry.hiddenTime = 0.0f;
+        }
+        stats.lodSkipped++;
+        break;
+    }
+    entry.lod = lod;
+}
+
+void ParticleManager::queueGpuStep(Entry& entry, float dt) {
+    GpuStep step{dt, entry.emitter->takeSpawnRequest(), entry.emitter->nextSeed()};
+
+    // Bound the backlog if rendering stalls: fold extra ticks into the last step
+    if (entry.pendingSteps.size() >= MAX_PENDING_GPU_STEPS) {
+        GpuStep& last = entry.pendingSteps.back();
+        last.dt += step.dt;
+        last.spawnCount += step.spawnCount;
+        return;
+    }
+    entry.pendingSteps.push_back(step);
+}
+
+const ParticleManager::ShaderUniforms& ParticleManager::uniformsFor(GLuint program) {
+    // A reloaded shader may have moved its uniforms
+    if (uniformCacheReloads != Shader::ReloadCount()) {
+        uniformCache.clear();
+        uniformCacheReloads = Shader::ReloadCount();
+    }
+    for (const ShaderUniforms& cached : uniformCache) {
+        if (cached.program == program) return cached;
+    }
+    uniformCache.push_back({program, glGetUniformLocation(program, "instanceOrigin"),
+                            glGetUniformLocation(program, "instanceScale")});
+    return uniformCache.back();
+}
+
+size_t ParticleManager::instanceStride() const {
+    return instanceFormat == ParticleInstanceFormat::Packed ? sizeof(PackedParticleInstance)
+                                                           : sizeof(ParticleInstanceData);
+}
+
+void ParticleManager::bindInstances(size_t first) {
+    const size_t base = first * instanceStride();
+    const GLsizei stride = static_cast<GLsizei>(instanceStride());
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    if (instanceFormat == ParticleInstanceFormat::Packed) {
+        glVertexAttribPointer(2, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)(base + offsetof(PackedParticleInstance, position)));
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(base + offsetof(PackedParticleInstance, color)));
+        glVertexAttribPointer(4, 1, GL_HALF_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(PackedParticleInstance, size)));
+        glVertexAttribPointer(5, 1, GL_HALF_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(PackedParticleInstance, rotation)));
+        return;
+    }
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(ParticleInstanceData, worldPosition)));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(ParticleInstanceData, color)));
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(ParticleInstanceData, size)));
+    glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(ParticleInstanceData, rotation)));
+}
+
+void ParticleManager::stepGpuEmitters() {
+    if (gpuProgram.id && gpuProgram.reloads != Shader::ReloadCount()) gpuProgram.findUniforms();
+    for (Entry& entry : entries) {
+        if (!entry.gpu) continue;
+        auto emitterStart = std::chrono::steady_clock::now();
+        // Sizes are computed in the update shader, so the distance LOD
+        // goes in with the config
+        ParticleEmitterConfig config = entry.emitter->getConfig();
+        config.startSize *= entry.emitter->getSizeScale();
+        config.endSize *= entry.emitter->getSizeScale();
+        for (const GpuStep& step : entry.pendingSteps) {
+            entry.gpu->step(gpuProgram, config, step.dt, step.spawnCount, step.seed);
+        }
+        entry.pendingSteps.clear();
+        entry.uploadMs = elapsed_ms(emitterStart);
+    }
+}
+
+void ParticleManager::buildGroups() {
+    groups.clear();
+    for (size_t i = 0; i < entries.size();) {
+        Group group{i, i, 0, false, {}};
+        GLuint shader = entries[i].shader;
+        ParticleBlend blend = entries[i].blend;
+        for (; i < entries.size() && entries[i].shader == shader && entries[i].blend == blend; i++) {
+            // Out of view emitters are neither uploaded nor drawn
+            if (entries[i].lod != ParticleLod::Full) continue;
+            group.instances += entries[i].gpu ? 0 : entries[i].emitter->getInstanceCount();
+            group.hasGpu |= entries[i].gpu != nullptr;
+        }
+        group.end = i;
+        groups.push_back(group);
+    }
+}
+
+ParticleDepthSorter& ParticleManager::sorterFor(GLuint shader) {
+    for (GroupSorter& cached : sorters) {
+        if (cached.shader == shader) return cached.sorter;
+    }
+    sorters.push_back({shader, {}});
+    return sorters.back().sorter;
+}
+
+bool ParticleManager::uploadInstances(size_t total, const glm::mat4& view,
+                                      const ParticleInstanceData* source) {
+    // Gather every emitter's instances into one contiguous upload. The
+    // buffer is invalidated so the driver never waits on last frame's draw.
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    void* buffer = glMapBufferRange(GL_ARRAY_BUFFER, 0, total * instanceStride(),
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!buffer) return false;
+    stats.uploadBytes = total * instanceStride();
+
+    bool packed = instanceFormat == ParticleInstanceFormat::Packed;
+    auto* mapped = static_cast<ParticleInstanceData*>(buffer);
+    auto* mappedPacked = static_cast<PackedParticleInstance*>(buffer);
+
+    size_t written = 0;
+    for (Group& group : groups) {
+        if (group.instances == 0) continue;
+
+        bool sorted = sortMode != ParticleSortMode::Off && entries[group.begin].blend == ParticleBlend::Alpha;
+        if (!sorted) {
+            // Packing needs the bounds of the whole draw up front
+            if (packed) {
+                bool first = true;
+                for (size_t i = group.begin; i < group.end; i++) {
+                    const Entry& entry = entries[i];
+                    if (entry.gpu || entry.lod != ParticleLod::Full || entry.emitter->getInstanceCount() == 0) continue;
+                    ParticlePackBounds bounds =
+                        particle_pack_bounds(source + entry.slice.offset, nullptr, entry.emitter->getInstanceCount());
+                    if (first) {
+                        group.bounds = bounds;
+                    } else {
+                        glm::vec3 hi = glm::max(group.bounds.origin + group.bounds.extent, bounds.origin + bounds.extent);
+                        group.bounds.origin = glm::min(group.bounds.origin, bounds.origin);
+                        group.bounds.extent = hi - group.bounds.origin;
+                    }
+                    first = false;
+                }
+            }
+            for (size_t i = group.begin; i < group.end; i++) {
+                Entry& entry = entries[i];
+                if (entry.gpu || entry.lod != ParticleLod::Full) continue;
+                auto emitterStart = std::chrono::steady_clock::now();
+                size_t count = entry.emitter->getInstanceCount();
+                if (packed) {
+                    pack_particle_instances(source + entry.slice.offset, nullptr, count, group.bounds,
+                                            mappedPacked + written);
+                } else {
+                    std::memcpy(mapped + written, source + entry.slice.offset, count * sizeof(ParticleInstanceData));
+                }
+                written += count;
+                entry.uploadMs = elapsed_ms(emitterStart);
+            }
+            continue;
+        }
+
+        // Sorted across every emitter in the group, then written in order
+        auto sortStart = std::chrono::steady_clock::now();
+        sortRanges.clear();
+        for (size_t i = group.begin; i < group.end; i++) {
+            if (entries[i].gpu || entries[i].lod != ParticleLod::Full) continue;
+            sortRanges.push_back({static_cast<uint32_t>(entries[i].slice.offset),
+                                  static_cast<uint32_t>(entries[i].emitter->getInstanceCount())});
+        }
+        ParticleDepthSorter& sorter = sorterFor(entries[group.begin].shader);
+        const auto& order = sorter.sort(source, sortRanges.data(), sortRanges.size(), view, sortMode, sortBudget);
+        if (packed) {
+            group.bounds = particle_pack_bounds(source, order.data(), order.size());
+            pack_particle_instances(source, order.data(), order.size(), group.bounds, mappedPacked + written);
+            written += order.size();
+        } else {
+            for (uint32_t id : order) mapped[written++] = source[id];
+        }
+
+        stats.sortMs += elapsed_ms(sortStart);
+        stats.sortShifts += sorter.getStats().shifts;
+        stats.radixSorts += sorter.getStats().radix;
+    }
+    // Contents were lost (e.g. a mode switch); skip a frame rather than draw garbage
+    return glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+}
+
+void ParticleManager::extrapolateInstances(float seconds) {
+    if (renderPool.size() < pool.size()) renderPool.resize(pool.size());
+    for (const Group& group : groups) {
+        for (size_t i = group.begin; i < group.end; i++) {
+            const Entry& entry = entries[i];
+            if (entry.gpu || entry.lod != ParticleLod::Full) continue;
+            const ParticleSoA& particles = entry.emitter->getParticles();
+            const ParticleInstanceData* in = pool.data() + entry.slice.offset;
+            ParticleInstanceData* out = renderPool.data() + entry.slice.offset;
+            size_t count = std::min(entry.emitter->getInstanceCount(), particles.count);
+            for (size_t k = 0; k < count; k++) {
+                out[k] = in[k];
+                out[k].worldPosition += glm::vec3(particles.velX[k], particles.velY[k], particles.velZ[k]) * seconds;
+            }
+        }
+    }
+}
+
+void ParticleManager::render(const glm::mat4& view, float extrapolate) {
+    auto start = std::chrono::steady_clock::now();
+    stats.particles = 0;
+    stats.drawCalls = 0;
+    stats.sortMs = 0.0;
+    stats.sortShifts = 0;
+    stats.radixSorts = 0;
+    stats.uploadBytes = 0;
+
+    // GPU simulation is GL work, so the ticks' steps run here on the main thread
+    stepGpuEmitters();
+
+    buildGroups();
+    size_t total = 0;
+    bool anyGpu = false;
+    for (const Group& group : groups) {
+        total += group.instances;
+        anyGpu |= group.hasGpu;
+    }
+    if (total == 0 && !anyGpu) {
+        stats.renderMs = elapsed_ms(start);
+        return;
+    }
+
+    // Between ticks, draw the particles where they are at the view's time
+    // rather than where the last tick left them; pool itself is untouched
+    const ParticleInstanceData* source = pool.data();
+    if (total > 0 && extrapolate != 0.0f) {
+        extrapolateInstances(extrapolate);
+        source = renderPool.data();
+    }
+    if (total > 0 && !uploadInstances(total, view, source)) return;
+
+    // Float instances and GPU state are plain world positions
+    const ParticlePackBounds world;
+    const bool packed = instanceFormat == ParticleInstanceFormat::Packed;
+
+    size_t first = 0;
+    for (const Group& group : groups) {
+        if (group.instances == 0 && !group.hasGpu) continue;
+
+        const ShaderUniforms& uniforms = uniformsFor(entries[group.begin].shader);
+        glUseProgram(uniforms.program);
+        apply_blend(entries[group.begin].blend);
+
+        if (group.instances > 0) {
+            const ParticlePackBounds& bounds = packed ? group.bounds : world;
+            glUniform3fv(uniforms.instanceOrigin, 1, &bounds.origin[0]);
+            glUniform3fv(uniforms.instanceScale, 1, &bounds.extent[0]);
+            // GL 3.3 has no base instance, so the attributes move instead
+            glBindVertexArray(VAO);
+            bindInstances(first);
+            glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(group.instances));
+            first += group.instances;
+            stats.drawCalls++;
+            stats.particles += group.instances;
+        }
+
+        // GPU emitters draw from their own state buffers, one call each
+        glUniform3fv(uniforms.instanceOrigin, 1, &world.origin[0]);
+        glUniform3fv(uniforms.instanceScale, 1, &world.extent[0]);
+        for (size_t i = group.begin; i < group.end; i++) {
+            if (!entries[i].gpu || entries[i].lod != ParticleLod::Full) continue;
+            entries[i].gpu->draw();
+            stats.drawCalls++;
+            stats.particles += entries[i].emitter->getParticleCount();
+        }
+    }
+
+    glBindVertexArray(0);
+    apply_blend(ParticleBlend::Alpha);
+
+    stats.renderMs = elapsed_ms(start);
+}
+
+const ParticleManager::Stats& ParticleManager::getStats() {
+    stats.emitters = entries.size();
+    stats.reserved = 0;
+    stats.perEmitter.clear();
+    for (const Entry& entry : entries) {
+        stats.reserved += entry.slice.size;
+        stats.perEmitter.push_back({entry.emitter.get(), entry.emitter->getInstanceCount(), entry.slice.size,
+                                    entry.updateMs, entry.uploadMs, entry.lod});
+    }
+    return stats;
+}
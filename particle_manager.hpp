@@ -0,0 +1,225 @@
+#pragma once
+#include "camera.hpp"
+#include "collider_store.hpp"
+#include "gpu_particles.hpp"
+#include "mygl.h"
+#include "particle_emitter.hpp"
+#include "particle_sort.hpp"
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+enum class ParticleInstanceFormat {
+    Float,  // ParticleInstanceData as simulated
+    Packed, // PackedParticleInstance, 16 bytes
+};
+
+enum class ParticleLod {
+    Full,    // in view: simulated every tick and drawn
+    Coarse,  // out of view: simulated every coarseInterval, not drawn
+    Skipped, // out of view: not simulated, fast-forwarded when seen again
+             // (CPU emitters without collision)
+};
+
+struct ParticleLodSettings {
+    bool enabled = true;
+    // Emitters closer than this get full emission rate and particle size,
+    // falling linearly to the minimum scales at lowDetailDistance
+    float fullDetailDistance = 25.0f;
+    float lowDetailDistance = 90.0f;
+    float minEmissionScale = 0.25f;
+    float minSizeScale = 0.5f;
+    float coarseInterval = 0.25f; // seconds between Coarse updates
+};
+
+// Owns every emitter and the GL side of particles: one quad, one instance
+// buffer sized to a global particle budget, and a slice of that budget per
+// emitter. Emitters sharing a shader and blend mode are uploaded next to
+// each other and drawn with a single instanced call.
+//
+// Alpha-blended groups are depth sorted back to front across all their
+// emitters before upload; additive ones are order independent and skip it.
+//
+// GPU-backend emitters still take a slice of the budget but simulate in
+// their own buffers, so they cost one extra draw each and are not sorted.
+//
+// Each update tests every emitter's bounds against the frustum from
+// setView. Emitters out of view are not drawn. CPU emitters stop
+// simulating and are fast-forwarded when they come back, which the
+// gravity and damping update allows in closed form. GPU and colliding
+// emitters keep stepping, but only every coarseInterval. Emitters in view scale their
+// emission and particle size down with distance.
+class ParticleManager {
+public:
+    static constexpr size_t DEFAULT_BUDGET = 65536;
+    static constexpr size_t MAX_PENDING_GPU_STEPS = 8;
+
+    explicit ParticleManager(size_t budget = DEFAULT_BUDGET);
+    ~ParticleManager();
+    ParticleManager(const ParticleManager&) = delete;
+    ParticleManager& operator=(const ParticleManager&) = delete;
+
+    // Reserves config.maxParticles from the budget, or whatever contiguous
+    // space is left when that is less. Null once the budget is spent.
+    ParticleEmitter* createEmitter(const ParticleEmitterConfig& config, GLuint shader);
+    void destroyEmitter(ParticleEmitter* emitter);
+
+    // Emitters live until destroyed, finished one-shots included, so
+    // pointers handed out stay valid
+    void update(float dt);
+    // view orders the alpha-blended particles; the shaders take the
+    // matrices from the frame's uniform block. CPU particles are drawn
+    // moved along their velocity by extrapolate seconds, so they line up
+    // with a view interpolated between ticks (negative: back in time).
+    void render(const glm::mat4& view, float extrapolate = 0.0f);
+
+    // budget is particles of sorting credit per frame for Budgeted; the
+    // group is fully sorted each time the credit covers it
+    void setSortMode(ParticleSortMode mode, size_t budget = ParticleDepthSorter::DEFAULT_BUDGET) {
+        sortMode = mode;
+        sortBudget = budget;
+    }
+
+    // Camera the next update picks levels of detail for. Without one every
+    // emitter runs at full detail.
+    void setView(const glm::vec3& eye, const Frustum& frustum);
+    void setLodSettings(const ParticleLodSettings& settings) { lodSettings = settings; }
+
+    // Static colliders for emitters with collision on, re-indexed when
+    // their version changes
+    void setColliders(const tCollidables& colliders) { colliderStore.sync(colliders); }
+
+    // Layout uploaded to the instance buffer. Shaders place instances at
+    // instanceOrigin + position * instanceScale: the group's bounds for
+    // Packed, zero and one otherwise.
+    void setInstanceFormat(ParticleInstanceFormat format) { instanceFormat = format; }
+
+    struct EmitterStats {
+        const ParticleEmitter* emitter;
+        size_t particles;
+        size_t capacity;
+        double updateMs;
+        double uploadMs; // GPU backend: time spent issuing its steps
+        ParticleLod lod;
+    };
+
+    // From the last update and render
+    struct Stats {
+        size_t budget = 0;
+        size_t reserved = 0;  // sum of emitter slices
+        size_t particles = 0; // drawn last frame
+        size_t emitters = 0;
+        size_t drawCalls = 0;
+        double updateMs = 0.0;
+        double renderMs = 0.0;
+        size_t uploadBytes = 0;
+        double sortMs = 0.0;
+        size_t sortShifts = 0;
+        size_t radixSorts = 0; // groups that needed the full sort
+        size_t lodFull = 0;    // emitters by level of detail, last update
+        size_t lodCoarse = 0;
+        size_t lodSkipped = 0;
+        std::vector<EmitterStats> perEmitter;
+    };
+    const Stats& getStats();
+
+private:
+    struct Slice {
+        size_t offset;
+        size_t size;
+    };
+
+    // One tick's worth of GPU simulation, run at the next render
+    struct GpuStep {
+        float dt;
+        size_t spawnCount;
+        uint32_t seed;
+    };
+
+    struct Entry {
+        std::unique_ptr<ParticleEmitter> emitter;
+        std::unique_ptr<GpuParticleSim> gpu; // set for the GPU backend
+        std::vector<GpuStep> pendingSteps;
+        GLuint shader;
+        ParticleBlend blend;
+        Slice slice;
+        double updateMs = 0.0;
+        double uploadMs = 0.0;
+        ParticleLod lod = ParticleLod::Full;
+        float hiddenTime = 0.0f; // out of view and not yet simulated
+    };
+
+    // A contiguous run of entries sharing a shader and blend mode
+    struct Group {
+        size_t begin, end;
+        size_t instances; // CPU backend
+        bool hasGpu;
+        ParticlePackBounds bounds; // Packed format
+    };
+
+    struct GroupSorter {
+        GLuint shader;
+        ParticleDepthSorter sorter;
+    };
+
+    struct ShaderUniforms {
+        GLuint program;
+        GLint instanceOrigin;
+        GLint instanceScale;
+    };
+
+    bool allocate(size_t count, Slice& out);
+    void release(Slice slice);
+    const ShaderUniforms& uniformsFor(GLuint program);
+    void bindInstances(size_t first);
+    void queueGpuStep(Entry& entry, float dt);
+    ParticleLod chooseLod(Entry& entry) const;
+    void updateEntry(Entry& entry, float dt);
+    void stepGpuEmitters();
+    void buildGroups();
+    ParticleDepthSorter& sorterFor(GLuint shader);
+    bool uploadInstances(size_t total, const glm::mat4& view, const ParticleInstanceData* source);
+    // The drawn emitters' instances moved by seconds of velocity, in renderPool
+    void extrapolateInstances(float seconds);
+    size_t instanceStride() const;
+
+    size_t budget;
+
+    // CPU side of the instance buffer; each emitter writes its own slice
+    std::vector<ParticleInstanceData> pool;
+    // pool as drawn this frame when render extrapolates; same layout
+    std::vector<ParticleInstanceData> renderPool;
+    std::vector<Slice> freeList; // sorted by offset, neighbours merged
+
+    // Sorted by (shader, blend) so each draw group is a contiguous run
+    std::vector<Entry> entries;
+    std::vector<ShaderUniforms> uniformCache;
+    uint32_t uniformCacheReloads = 0; // Shader::ReloadCount() it was filled at
+    std::vector<Group> groups; // rebuilt each render
+
+    // The 16-bit radix sort is cheap enough that repairing last frame's
+    // order rarely beats it (bench "sort"), so it is the default
+    ParticleSortMode sortMode = ParticleSortMode::Full;
+    size_t sortBudget = ParticleDepthSorter::DEFAULT_BUDGET;
+    std::vector<GroupSorter> sorters; // one per alpha-blended shader
+    std::vector<ParticleDepthSorter::Range> sortRanges;
+
+    GLuint VAO = 0;
+    GLuint quadVBO = 0;
+    GLuint quadEBO = 0;
+    GLuint instanceVBO = 0;
+
+    ParticleInstanceFormat instanceFormat = ParticleInstanceFormat::Float;
+
+    ParticleLodSettings lodSettings;
+    bool hasView = false;
+    glm::vec3 eye = glm::vec3(0.0f);
+    Frustum frustum{};
+
+    GpuParticleProgram gpuProgram; // created with the first GPU emitter
+
+    ColliderStore colliderStore;
+
+    Stats stats;
+};
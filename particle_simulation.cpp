@@ -0,0 +1,272 @@
+#include "particle_simulation.hpp"
+#include "half.hpp"
+#include "particle_collision.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+void ParticleSoA::reserve(size_t maxParticles) {
+    limit = maxParticles;
+    size_t padded = (maxParticles + 3) & ~size_t(3);
+    for (auto* array : {&posX, &posY, &posZ, &velX, &velY, &velZ, &life, &size, &rotation, &rotationSpeed}) {
+        array->resize(padded, 0.0f);
+    }
+    dead.reserve(padded);
+}
+
+bool ParticleSoA::push(const glm::vec3& position, const glm::vec3& velocity, float lifeTime,
+                       float startSize, float startRotation, float spin) {
+    if (count == capacity()) return false;
+    size_t i = count++;
+    posX[i] = position.x;
+    posY[i] = position.y;
+    posZ[i] = position.z;
+    velX[i] = velocity.x;
+    velY[i] = velocity.y;
+    velZ[i] = velocity.z;
+    life[i] = lifeTime;
+    size[i] = startSize;
+    rotation[i] = startRotation;
+    rotationSpeed[i] = spin;
+    return true;
+}
+
+void ParticleSoA::swap_remove(size_t i) {
+    size_t last = --count;
+    if (i == last) return;
+    posX[i] = posX[last];
+    posY[i] = posY[last];
+    posZ[i] = posZ[last];
+    velX[i] = velX[last];
+    velY[i] = velY[last];
+    velZ[i] = velZ[last];
+    life[i] = life[last];
+    size[i] = size[last];
+    rotation[i] = rotation[last];
+    rotationSpeed[i] = rotationSpeed[last];
+}
+
+size_t particles_spawn(ParticleSoA& particles, const ParticleEmitterConfig& config, size_t n, Rng4& rng) {
+    n = std::min(n, particles.capacity() - particles.count);
+    size_t b = particles.count;
+
+    rng.fill_centered(&particles.posX[b], n, config.spawnPosition.x, config.spawnPositionVariance.x);
+    rng.fill_centered(&particles.posY[b], n, config.spawnPosition.y, config.spawnPositionVariance.y);
+    rng.fill_centered(&particles.posZ[b], n, config.spawnPosition.z, config.spawnPositionVariance.z);
+    rng.fill_centered(&particles.velX[b], n, config.initialVelocity.x, config.velocityVariance.x);
+    rng.fill_centered(&particles.velY[b], n, config.initialVelocity.y, config.velocityVariance.y);
+    rng.fill_centered(&particles.velZ[b], n, config.initialVelocity.z, config.velocityVariance.z);
+    rng.fill_centered(&particles.life[b], n, config.particleLifetime, config.lifetimeVariance);
+    rng.fill_centered(&particles.size[b], n, config.startSize, config.sizeVariance);
+    rng.fill_range(&particles.rotation[b], n, 0.0f, 2.0f * static_cast<float>(M_PI));
+    rng.fill_centered(&particles.rotationSpeed[b], n, config.rotationSpeed, config.rotationVariance);
+
+    particles.count += n;
+    return n;
+}
+
+size_t particles_update(ParticleSoA& particles, const ParticleEmitterConfig& config, float dt,
+                        ParticleInstanceData* out, ParticleColliders* colliders) {
+    using namespace simd;
+
+    const f32x4 vdt = set1(dt);
+    const f32x4 damping = set1(config.damping);
+    const f32x4 gx = set1(config.gravity.x * dt);
+    const f32x4 gy = set1(config.gravity.y * dt);
+    const f32x4 gz = set1(config.gravity.z * dt);
+    const f32x4 invLifetime = set1(1.0f / config.particleLifetime);
+
+    // Colour and size are end + (start - end) * lifeRatio
+    f32x4 colorBase[4], colorScale[4];
+    for (int c = 0; c < 4; c++) {
+        colorBase[c] = set1(config.endColor[c]);
+        colorScale[c] = set1(config.startColor[c] - config.endColor[c]);
+    }
+    const f32x4 sizeBase = set1(config.endSize);
+    const f32x4 sizeScale = set1(config.startSize - config.endSize);
+
+    float* posX = particles.posX.data();
+    float* posY = particles.posY.data();
+    float* posZ = particles.posZ.data();
+    float* velX = particles.velX.data();
+    float* velY = particles.velY.data();
+    float* velZ = particles.velZ.data();
+    float* life = particles.life.data();
+    const float* size = particles.size.data();
+    float* rotation = particles.rotation.data();
+    const float* rotationSpeed = particles.rotationSpeed.data();
+
+    size_t count = particles.count;
+    particles.dead.clear();
+    if (colliders && colliders->empty()) colliders = nullptr;
+
+    for (size_t i = 0; i < count; i += 4) {
+        f32x4 vx = (load(velX + i) + gx) * damping;
+        f32x4 vy = (load(velY + i) + gy) * damping;
+        f32x4 vz = (load(velZ + i) + gz) * damping;
+        f32x4 px = madd(vx, vdt, load(posX + i));
+        f32x4 py = madd(vy, vdt, load(posY + i));
+        f32x4 pz = madd(vz, vdt, load(posZ + i));
+        f32x4 rot = madd(load(rotationSpeed + i), vdt, load(rotation + i));
+        f32x4 remaining = load(life + i) - vdt;
+
+        // Lanes past count are padding
+        size_t lanes = std::min<size_t>(count - i, 4);
+        int valid = (1 << lanes) - 1;
+
+        if (colliders) {
+            const f32x4 old[3] = {load(posX + i), load(posY + i), load(posZ + i)};
+            f32x4 position[3] = {px, py, pz};
+            f32x4 velocity[3] = {vx, vy, vz};
+            particles_collide(*colliders, config, old, position, velocity, remaining, valid);
+            px = position[0], py = position[1], pz = position[2];
+            vx = velocity[0], vy = velocity[1], vz = velocity[2];
+        }
+
+        store(velX + i, vx);
+        store(velY + i, vy);
+        store(velZ + i, vz);
+        store(posX + i, px);
+        store(posY + i, py);
+        store(posZ + i, pz);
+        store(rotation + i, rot);
+        store(life + i, remaining);
+
+        int deadMask = movemask(cmple(remaining, zero())) & valid;
+
+        // Every lane gets an instance in its own slot; the dead ones are
+        // overwritten by the swap-removes below
+        f32x4 ratio = remaining * invLifetime;
+        float lane[9][4];
+        store(lane[0], px);
+        store(lane[1], py);
+        store(lane[2], pz);
+        for (int c = 0; c < 4; c++) {
+            store(lane[3 + c], madd(colorScale[c], ratio, colorBase[c]));
+        }
+        store(lane[7], madd(sizeScale, ratio, sizeBase) * load(size + i));
+        store(lane[8], rot);
+
+        for (size_t l = 0; l < lanes; l++) {
+            ParticleInstanceData& instance = out[i + l];
+            instance.worldPosition = glm::vec3(lane[0][l], lane[1][l], lane[2][l]);
+            instance.color = glm::vec4(lane[3][l], lane[4][l], lane[5][l], lane[6][l]);
+            instance.size = lane[7][l];
+            instance.rotation = lane[8][l];
+        }
+
+        while (deadMask) {
+            particles.dead.push_back(static_cast<uint32_t>(i + __builtin_ctz(deadMask)));
+            deadMask &= deadMask - 1;
+        }
+    }
+
+    // Highest index first: everything past it is then known to be alive,
+    // so the particle swapped in never needs checking again. The instances
+    // move with their particles, so instance k stays particle k.
+    for (size_t k = particles.dead.size(); k-- > 0;) {
+        size_t slot = particles.dead[k];
+        out[slot] = out[particles.count - 1];
+        particles.swap_remove(slot);
+    }
+
+    return particles.count;
+}
+
+// Moves particle i on by t; the caller handles its life
+static void advance_particle(ParticleSoA& particles, size_t i, const ParticleEmitterConfig& config, float t, float h) {
+    const float steps = t / h;
+    const float d = config.damping;
+    const glm::vec3 kick = config.gravity * h; // velocity gained per step
+    const glm::vec3 v0(particles.velX[i], particles.velY[i], particles.velZ[i]);
+
+    // v[k] = d * (v[k-1] + kick), p[k] = p[k-1] + h * v[k]
+    glm::vec3 velocity, travel;
+    if (std::abs(1.0f - d) < 1e-6f) {
+        velocity = v0 + kick * steps;
+        travel = h * (v0 * steps + kick * (0.5f * steps * (steps + 1.0f)));
+    } else {
+        // Converges on the terminal velocity d * kick / (1 - d)
+        const float decay = std::pow(d, steps);
+        const glm::vec3 terminal = kick * (d / (1.0f - d));
+        velocity = terminal + (v0 - terminal) * decay;
+        travel = h * (terminal * steps + (v0 - terminal) * (d * (1.0f - decay) / (1.0f - d)));
+    }
+
+    particles.velX[i] = velocity.x;
+    particles.velY[i] = velocity.y;
+    particles.velZ[i] = velocity.z;
+    particles.posX[i] += travel.x;
+    particles.posY[i] += travel.y;
+    particles.posZ[i] += travel.z;
+    particles.rotation[i] += particles.rotationSpeed[i] * t;
+}
+
+void particles_fast_forward(ParticleSoA& particles, const ParticleEmitterConfig& config, float t, float h) {
+    if (t <= 0.0f || h <= 0.0f) return;
+    // Backwards, so whatever a swap-remove moves in is already done
+    for (size_t i = particles.count; i-- > 0;) {
+        particles.life[i] -= t;
+        if (particles.life[i] <= 0.0f) {
+            particles.swap_remove(i);
+            continue;
+        }
+        advance_particle(particles, i, config, t, h);
+    }
+}
+
+size_t particles_spawn_aged(ParticleSoA& particles, const ParticleEmitterConfig& config, size_t n,
+                            float minAge, float maxAge, float h, Rng4& rng) {
+    size_t first = particles.count;
+    particles_spawn(particles, config, n, rng);
+    for (size_t i = particles.count; i-- > first;) {
+        float age = rng.range(minAge, maxAge);
+        particles.life[i] -= age;
+        if (particles.life[i] <= 0.0f) {
+            particles.swap_remove(i);
+            continue;
+        }
+        if (h > 0.0f) advance_particle(particles, i, config, age, h);
+    }
+    return particles.count - first;
+}
+
+static uint8_t unorm8(float x) {
+    return static_cast<uint8_t>(std::clamp(x, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+ParticlePackBounds particle_pack_bounds(const ParticleInstanceData* in, const uint32_t* order, size_t n) {
+    if (n == 0) return {};
+    glm::vec3 lo = in[order ? order[0] : 0].worldPosition;
+    glm::vec3 hi = lo;
+    for (size_t i = 1; i < n; i++) {
+        const glm::vec3& p = in[order ? order[i] : i].worldPosition;
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+    // A flat box still needs a non-zero extent to divide by
+    return {lo, glm::max(hi - lo, glm::vec3(1e-6f))};
+}
+
+void pack_particle_instances(const ParticleInstanceData* in, const uint32_t* order, size_t n,
+                             const ParticlePackBounds& bounds, PackedParticleInstance* out) {
+    const float twoPi = 2.0f * static_cast<float>(M_PI);
+    const glm::vec3 scale = glm::vec3(65535.0f) / bounds.extent;
+    for (size_t i = 0; i < n; i++) {
+        const ParticleInstanceData& instance = in[order ? order[i] : i];
+        PackedParticleInstance& packed = out[i];
+        glm::vec3 unit = (instance.worldPosition - bounds.origin) * scale + 0.5f;
+        packed.position[0] = static_cast<uint16_t>(std::clamp(unit.x, 0.0f, 65535.0f));
+        packed.position[1] = static_cast<uint16_t>(std::clamp(unit.y, 0.0f, 65535.0f));
+        packed.position[2] = static_cast<uint16_t>(std::clamp(unit.z, 0.0f, 65535.0f));
+        packed.size = float_to_half(instance.size);
+        packed.color[0] = unorm8(instance.color.x);
+        packed.color[1] = unorm8(instance.color.y);
+        packed.color[2] = unorm8(instance.color.z);
+        packed.color[3] = unorm8(instance.color.w);
+        // Rotation grows without bound; wrap it before it loses precision
+        packed.rotation = float_to_half(instance.rotation - twoPi * std::floor(instance.rotation / twoPi));
+        packed.padding = 0;
+    }
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "rng.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+enum class ParticleBlend {
+    Alpha,    // src * a + dst * (1 - a)
+    Additive, // src * a + dst, for fire and sparks
+};
+
+enum class ParticleBackend {
+    Cpu, // SIMD update on the CPU, instances uploaded every frame
+    Gpu, // state stays in GPU buffers, updated by transform feedback
+};
+
+enum class ParticleCollision {
+    None,
+    Bounce, // off the surface, keeping restitution of the normal speed
+    Kill,   // dies on contact
+};
+
+struct ParticleColliders;
+
+struct ParticleEmitterConfig {
+    // Emission
+    float emissionRate = 50.0f;  // particles per second
+    int maxParticles = 1000;
+
+    // Spawn properties
+    glm::vec3 spawnPosition = glm::vec3(0.0f);
+    glm::vec3 spawnPositionVariance = glm::vec3(0.1f);
+    glm::vec3 initialVelocity = glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::vec3 velocityVariance = glm::vec3(0.5f);
+
+    // Particle properties
+    float particleLifetime = 2.0f;
+    float lifetimeVariance = 0.5f;
+    float startSize = 0.1f;
+    float endSize = 0.05f;
+    float sizeVariance = 0.02f;
+
+    // Color over lifetime
+    glm::vec4 startColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    glm::vec4 endColor = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+
+    // Physics
+    glm::vec3 gravity = glm::vec3(0.0f, -9.81f, 0.0f);
+    float damping = 0.98f;
+
+    // Rotation
+    float rotationSpeed = 0.0f;
+    float rotationVariance = 1.0f;
+
+    // Simulation
+    bool looping = true;
+    float duration = 5.0f;  // Only used if looping is false
+
+    ParticleBackend backend = ParticleBackend::Cpu;
+
+    // Against the static colliders; CPU backend only
+    ParticleCollision collision = ParticleCollision::None;
+    float restitution = 0.4f; // share of the normal speed a bounce keeps
+    float friction = 0.2f;    // share of the tangential speed a bounce loses
+
+    // Emitters sharing a shader and blend mode are drawn together
+    ParticleBlend blend = ParticleBlend::Alpha;
+
+    // Random stream; 0 picks a fresh seed per emitter, anything else
+    // replays the same particles every run
+    uint64_t seed = 0;
+};
+
+// Instance data uploaded to GPU
+struct ParticleInstanceData {
+    glm::vec3 worldPosition;
+    glm::vec4 color;
+    float size;
+    float rotation;
+};
+
+// The same instance in 16 bytes: position as 16-bit fractions of a box
+// (the bounds of everything in the draw), RGBA8 colour and half-float
+// size and rotation. The shader maps the position back with the box
+// origin and extent.
+struct PackedParticleInstance {
+    uint16_t position[3];
+    uint16_t size;
+    uint8_t color[4];
+    uint16_t rotation;
+    uint16_t padding;
+};
+static_assert(sizeof(PackedParticleInstance) == 16, "PackedParticleInstance must stay 16 bytes");
+
+// Live particles, one array per attribute so the update streams through
+// exactly the floats it needs. Arrays are padded to a multiple of four so
+// the SIMD kernel never needs a scalar tail.
+struct ParticleSoA {
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> velX, velY, velZ;
+    std::vector<float> life;
+    std::vector<float> size;
+    std::vector<float> rotation;
+    std::vector<float> rotationSpeed;
+    size_t count = 0;
+    size_t limit = 0;
+
+    // Scratch for particles_update, kept to avoid allocating per frame
+    std::vector<uint32_t> dead;
+
+    size_t capacity() const { return limit; }
+    void reserve(size_t maxParticles);
+    void clear() { count = 0; }
+
+    // Returns false when full
+    bool push(const glm::vec3& position, const glm::vec3& velocity, float lifeTime,
+              float startSize, float startRotation, float spin);
+
+    // Moves the last particle into slot i - O(1), order is not kept
+    void swap_remove(size_t i);
+};
+
+// Appends up to n particles (fewer when full) spread by the config's
+// variances. Each attribute is drawn for the whole batch straight into its
+// array. Returns the number added.
+size_t particles_spawn(ParticleSoA& particles, const ParticleEmitterConfig& config, size_t n, Rng4& rng);
+
+// Integrates every particle by dt, swap-removes the dead and leaves the
+// instance for particle k in out[k] (out must hold count entries). A
+// particle keeps its slot, and so its instance, until a swap-remove moves
+// it. Returns the number of instances, which is the new count. With
+// colliders, each step is also collided (see particle_collision.hpp).
+size_t particles_update(ParticleSoA& particles, const ParticleEmitterConfig& config, float dt,
+                        ParticleInstanceData* out, ParticleColliders* colliders = nullptr);
+
+// Advances every particle by t as if updated in steps of h, without
+// stepping: the update's damped velocity is a geometric series, so both it
+// and the position after t / h steps have a closed form. Particles that
+// would have died are swap-removed. Instances are left alone.
+void particles_fast_forward(ParticleSoA& particles, const ParticleEmitterConfig& config, float t, float h);
+
+// Spawns up to n particles as if emitted at random ages in [minAge, maxAge)
+// and fast-forwarded since. The ones already past their lifetime are not
+// kept. Returns the number kept.
+size_t particles_spawn_aged(ParticleSoA& particles, const ParticleEmitterConfig& config, size_t n,
+                            float minAge, float maxAge, float h, Rng4& rng);
+
+// Box that position packing is relative to
+struct ParticlePackBounds {
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 extent = glm::vec3(1.0f);
+};
+
+// Bounds of n instances, with an optional order as below
+ParticlePackBounds particle_pack_bounds(const ParticleInstanceData* in, const uint32_t* order, size_t n);
+
+// Packs n instances into bounds. With an order, out[i] is in[order[i]],
+// otherwise in[i].
+void pack_particle_instances(const ParticleInstanceData* in, const uint32_t* order, size_t n,
+                             const ParticlePackBounds& bounds, PackedParticleInstance* out);
@@ -0,0 +1,215 @@
+#include "particle_sort.hpp"
+#include <algorithm>
+#include <cassert>
+
+const std::vector<uint32_t>& ParticleDepthSorter::sort(const ParticleInstanceData* pool, const Range* ranges,
+                                                       size_t rangeCount, const glm::mat4& view,
+                                                       ParticleSortMode mode, size_t budget) {
+    stats = {};
+
+    size_t poolEnd = 0;
+    for (size_t r = 0; r < rangeCount; r++) {
+        poolEnd = std::max(poolEnd, static_cast<size_t>(ranges[r].first) + ranges[r].count);
+    }
+    if (keys.size() < poolEnd) {
+        keys.resize(poolEnd);
+        depths.resize(poolEnd);
+        stamp.resize(poolEnd, 0);
+    }
+
+    // Live particles get 2 * frame, and 2 * frame + 1 once found in last
+    // frame's order, so anything still on the even stamp is new
+    frame++;
+    const uint32_t live = 2 * frame;
+    const uint32_t kept = live + 1;
+
+    // Budgeted frames between full sorts keep the keys from the last one,
+    // so only the particles not in last frame's order need a key
+    bool fullSort = mode != ParticleSortMode::Budgeted;
+    if (!fullSort) {
+        size_t liveCount = 0;
+        for (size_t r = 0; r < rangeCount; r++) liveCount += ranges[r].count;
+        // No credit would leave the group on its first frame's keys forever
+        assert(budget > 0 && "Budgeted sorting needs a non-zero budget");
+        credit += budget;
+        if (credit >= liveCount) {
+            credit -= liveCount;
+            fullSort = true;
+        }
+    }
+
+    // View-space z; more negative is farther
+    const float zx = view[0][2], zy = view[1][2], zz = view[2][2], zw = view[3][2];
+    auto view_z = [&](uint32_t id) {
+        const glm::vec3& p = pool[id].worldPosition;
+        return zx * p.x + zy * p.y + zz * p.z + zw;
+    };
+
+    for (size_t r = 0; r < rangeCount; r++) {
+        for (uint32_t id = ranges[r].first; id < ranges[r].first + ranges[r].count; id++) stamp[id] = live;
+    }
+
+    if (fullSort) {
+        float minZ = 0.0f, maxZ = 0.0f;
+        bool first = true;
+        for (size_t r = 0; r < rangeCount; r++) {
+            for (uint32_t id = ranges[r].first; id < ranges[r].first + ranges[r].count; id++) {
+                float z = view_z(id);
+                depths[id] = z;
+                minZ = first ? z : std::min(minZ, z);
+                maxZ = first ? z : std::max(maxZ, z);
+                first = false;
+            }
+        }
+
+        // Quantize so that the farthest particle gets key 0
+        keyOffset = minZ;
+        keyScale = maxZ > minZ ? 65535.0f / (maxZ - minZ) : 0.0f;
+        for (size_t r = 0; r < rangeCount; r++) {
+            for (uint32_t id = ranges[r].first; id < ranges[r].first + ranges[r].count; id++) {
+                keys[id] = static_cast<uint16_t>((depths[id] - keyOffset) * keyScale);
+            }
+        }
+    }
+
+    // Last frame's order minus the dead; new arrivals go straight to the
+    // misplaced list
+    size_t write = 0;
+    for (uint32_t id : order) {
+        if (id < poolEnd && stamp[id] == live) {
+            stamp[id] = kept;
+            order[write++] = id;
+        }
+    }
+    order.resize(write);
+    misplaced.clear();
+    for (size_t r = 0; r < rangeCount; r++) {
+        for (uint32_t id = ranges[r].first; id < ranges[r].first + ranges[r].count; id++) {
+            if (stamp[id] != live) continue;
+            if (!fullSort) {
+                float key = std::clamp((view_z(id) - keyOffset) * keyScale, 0.0f, 65535.0f);
+                keys[id] = static_cast<uint16_t>(key);
+            }
+            misplaced.push_back(id);
+        }
+    }
+
+    size_t total = order.size() + misplaced.size();
+    stats.sorted = total;
+
+    switch (mode) {
+    case ParticleSortMode::Off:
+        order.insert(order.end(), misplaced.begin(), misplaced.end());
+        break;
+    case ParticleSortMode::Full:
+        order.insert(order.end(), misplaced.begin(), misplaced.end());
+        radixSort(order);
+        break;
+    case ParticleSortMode::Coherent: {
+        if (radixFrames > 0) {
+            radixFrames--;
+            order.insert(order.end(), misplaced.begin(), misplaced.end());
+            radixSort(order);
+            break;
+        }
+        size_t limit = total / COHERENT_MISPLACED_DIVISOR;
+        extractMisplaced(limit + 1);
+        if (misplaced.size() > limit || !insertionSort(order.size() * COHERENT_SHIFTS_PER_PARTICLE)) {
+            order.insert(order.end(), misplaced.begin(), misplaced.end());
+            radixSort(order);
+            radixFrames = COHERENT_BACKOFF_FRAMES;
+        } else {
+            mergeMisplaced();
+        }
+        break;
+    }
+    case ParticleSortMode::Budgeted:
+        if (fullSort) {
+            order.insert(order.end(), misplaced.begin(), misplaced.end());
+            radixSort(order);
+        } else {
+            mergeMisplaced();
+        }
+        break;
+    }
+    return order;
+}
+
+void ParticleDepthSorter::extractMisplaced(size_t maxMoved) {
+    // Keep a run that never drops more than the tolerance below the last
+    // kept key; a key above its successor by more than the tolerance is a
+    // spike and goes too
+    size_t write = 0;
+    int last = -1;
+    for (size_t i = 0; i < order.size(); i++) {
+        uint32_t id = order[i];
+        int key = keys[id];
+        bool out = key + MISPLACED_TOLERANCE < last ||
+                   (i + 1 < order.size() && key > keys[order[i + 1]] + MISPLACED_TOLERANCE);
+        if (out && misplaced.size() < maxMoved) {
+            misplaced.push_back(id);
+            continue;
+        }
+        order[write++] = id;
+        last = std::max(last, key);
+    }
+    order.resize(write);
+}
+
+void ParticleDepthSorter::mergeMisplaced() {
+    stats.misplaced = misplaced.size();
+    if (misplaced.empty()) return;
+    radixSort(misplaced);
+    scratch.resize(order.size() + misplaced.size());
+    std::merge(order.begin(), order.end(), misplaced.begin(), misplaced.end(), scratch.begin(),
+               [this](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+    order.swap(scratch);
+}
+
+void ParticleDepthSorter::radixSort(std::vector<uint32_t>& ids) {
+    if (&ids == &order) stats.radix = true;
+    size_t n = ids.size();
+    scratch.resize(n);
+
+    uint32_t low[256] = {};
+    uint32_t high[256] = {};
+    for (uint32_t id : ids) {
+        low[keys[id] & 0xff]++;
+        high[keys[id] >> 8]++;
+    }
+
+    // Exclusive prefix sums
+    uint32_t lowSum = 0, highSum = 0;
+    for (int bucket = 0; bucket < 256; bucket++) {
+        uint32_t l = low[bucket], h = high[bucket];
+        low[bucket] = lowSum;
+        high[bucket] = highSum;
+        lowSum += l;
+        highSum += h;
+    }
+
+    for (uint32_t id : ids) scratch[low[keys[id] & 0xff]++] = id;
+    for (size_t i = 0; i < n; i++) ids[high[keys[scratch[i]] >> 8]++] = scratch[i];
+}
+
+bool ParticleDepthSorter::insertionSort(size_t maxShifts) {
+    size_t shifts = 0;
+    for (size_t i = 1; i < order.size(); i++) {
+        uint32_t id = order[i];
+        uint16_t key = keys[id];
+        size_t j = i;
+        while (j > 0 && keys[order[j - 1]] > key) {
+            if (shifts == maxShifts) {
+                order[j] = id;
+                stats.shifts = shifts;
+                return false;
+            }
+            order[j] = order[j - 1];
+            j--;
+            shifts++;
+        }
+        order[j] = id;
+    }
+    stats.shifts = shifts;
+    return true;
+}
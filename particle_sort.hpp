@@ -0,0 +1,101 @@
+#pragma once
+#include "particle_simulation.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+enum class ParticleSortMode {
+    Off,      // spawn order
+    Full,     // radix sort every frame
+    Coherent, // repair last frame's order, radix sort when that would cost more
+    Budgeted, // full sorts paced to a particle budget, new particles merged in between
+};
+
+// Back-to-front order for alpha-blended particles.
+//
+// Keys are view depth quantized to 16 bits over the frame's depth range,
+// sorted with a two-pass LSD radix sort. Both other modes start from last
+// frame's order, which is usually almost right:
+//
+// Coherent pulls out the entries that jumped out of place (new particles,
+// and the ones a swap-remove moved into a dead particle's slot), repairs
+// the rest with insertion sort, which is linear on nearly sorted input, and
+// merges the two. Dense effects under a moving camera reorder too much for
+// that to win, so when the repair runs over its limit it radix sorts and
+// stays on radix for a few frames before trying again.
+//
+// Budgeted earns `budget` particles of sorting credit a frame and runs a
+// full sort when the credit covers the group. In between, nothing already
+// in the order is touched: only new particles get keys and are merged in,
+// against the keys of the last full sort. A large effect is re-sorted
+// every few frames at a fixed average cost, and is slightly out of order
+// in between. Only the average is bounded: a frame that does sort still
+// pays for the whole radix pass. The budget must be non-zero.
+//
+// Particles are identified by their index in the instance pool. Instance k
+// of an emitter is its particle k, which keeps its slot until a
+// swap-remove moves it.
+class ParticleDepthSorter {
+public:
+    struct Range {
+        uint32_t first;
+        uint32_t count;
+    };
+
+    struct Stats {
+        size_t sorted = 0;
+        size_t misplaced = 0; // pulled out and merged back, new ones included
+        size_t shifts = 0;    // insertion sort moves
+        bool radix = false;   // ran the full sort
+    };
+
+    // Sorts the live instances pool[range.first .. + range.count) of every
+    // range, farthest first. The result holds pool indices.
+    const std::vector<uint32_t>& sort(const ParticleInstanceData* pool, const Range* ranges, size_t rangeCount,
+                                      const glm::mat4& view, ParticleSortMode mode,
+                                      size_t budget = DEFAULT_BUDGET);
+
+    const std::vector<uint32_t>& getOrder() const { return order; }
+    const Stats& getStats() const { return stats; }
+
+    // Particles of Budgeted sorting credit earned per frame unless set
+    static constexpr size_t DEFAULT_BUDGET = 16384;
+
+    // Coherent radix sorts everything once more than 1 / COHERENT_MISPLACED_DIVISOR
+    // of the entries are misplaced, or the insertion sort passes this many
+    // shifts per particle
+    static constexpr size_t COHERENT_MISPLACED_DIVISOR = 4;
+    static constexpr size_t COHERENT_SHIFTS_PER_PARTICLE = 4;
+
+    // Keys more than this far below their predecessor count as misplaced
+    static constexpr uint16_t MISPLACED_TOLERANCE = 256;
+
+    // Frames Coherent stays on radix after falling back
+    static constexpr int COHERENT_BACKOFF_FRAMES = 8;
+
+private:
+    void radixSort(std::vector<uint32_t>& ids);
+    // Moves entries that break the order out of `order` into `misplaced`,
+    // up to maxMoved of them
+    void extractMisplaced(size_t maxMoved);
+    // False when the shift limit ran out first
+    bool insertionSort(size_t maxShifts);
+    void mergeMisplaced();
+
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> misplaced;
+    std::vector<uint32_t> scratch;
+    std::vector<uint16_t> keys;    // by pool index
+    std::vector<float> depths;     // by pool index, scratch for the full sort
+    std::vector<uint32_t> stamp;   // by pool index, which frame it was last live
+    uint32_t frame = 0;
+    int radixFrames = 0; // Coherent backoff left
+    size_t credit = 0;   // Budgeted
+
+    // Depth to key mapping from the last full key pass
+    float keyOffset = 0.0f;
+    float keyScale = 0.0f;
+
+    Stats stats;
+};
@@ -1,29 +1,78 @@
 #include "render_system.hpp"
+#include "bounds.hpp"
 #include "camera.hpp"
+#include "culling.hpp"
+#include "frame_uniforms.hpp"
 #include "model.hpp"
 #include "model_setup.hpp"
+#include "job_system.hpp"
+
+// Render queue rebuilt every frame: transforms, local bounds and the model
+// they belong to live in parallel arrays, and world bounds are kept SoA so
+// the bounds update and cull passes stream over plain floats.
+static std::vector<glm::mat4> queueTransforms;
+static std::vector<AABB> queueLocalBounds;
+static std::vector<Model *> queueModels;
+static BoundsSoA queueBounds;
+static std::vector<uint32_t> visible;
+static CullScratch cullScratch;
+
+// Visible meshes bucketed by the shader variant their material needs, so
+// each variant is bound once a frame
+struct MeshDraw {
+  Model *model;
+  uint32_t mesh;
+};
+static std::vector<MeshDraw> variantDraws[MATERIAL_VARIANTS];
 
 void render_system_init() {
 
 }
 void render_system_update() {
   Camera &camera = entt::locator<Camera>::value();
-  Meta &meta = entt::locator<Meta>::value();
-  Shaders &shaders = entt::locator<Shaders>::value();
+  JobSystem &jobs = entt::locator<JobSystem>::value();
 
-  glm::mat4 projection = glm::perspective(
-      glm::radians(camera.Zoom),
-      meta.WindowDimensions.x / meta.WindowDimensions.y, 0.1f, 1000.0f);
+  const FrameUniforms &frame = frame_uniforms();
+  camera.CalculateFrustum(frame.projection, frame.view);
 
+  queueTransforms.clear();
+  queueLocalBounds.clear();
+  queueModels.clear();
+  for (auto [entity, model] : ecs.view<Model>().each()) {
+    queueTransforms.push_back(model.transform);
+    queueLocalBounds.push_back(model.aabb);
+    queueModels.push_back(&model);
+  }
 
-  glm::mat4 view = camera.GetViewMatrix();
+  queueBounds.resize(queueModels.size());
+  jobs.parallel_for(queueModels.size(), 4096,
+                    [&](size_t begin, size_t end, unsigned int) {
+                      update_world_bounds(queueTransforms.data(),
+                                          queueLocalBounds.data(), begin, end,
+                                          queueBounds);
+                    });
 
-  Shader::Use(shaders.MAIN);
-  Shader::SetMat4("projection", shaders.MAIN, projection);
-  Shader::SetMat4("view", shaders.MAIN, view);
-  Shader::SetVec3("viewPos", shaders.MAIN, camera.Position);
+  cull_parallel(jobs, queueBounds, camera.ViewFrustum, cullScratch, visible);
+
+  for (std::vector<MeshDraw> &draws : variantDraws)
+    draws.clear();
+  for (uint32_t index : visible) {
+    Model *model = queueModels[index];
+    for (uint32_t mesh = 0; mesh < model->meshes.size(); mesh++) {
+      const Material &material =
+          model->materials[model->meshes[mesh].material_index];
+      variantDraws[materialFeatures(material)].push_back({model, mesh});
+    }
+  }
 
-  for (auto [entity, model] : ecs.view<Model>().each()){
-    drawModel(shaders.MAIN, &model, 1);
+  for (uint32_t features = 0; features < MATERIAL_VARIANTS; features++) {
+    if (variantDraws[features].empty())
+      continue;
+    unsigned int shader = materialShader(features);
+    Shader::Use(shader);
+    for (const MeshDraw &draw : variantDraws[features]) {
+      drawMesh(shader, draw.model, draw.mesh, 1);
+    }
   }
+  glBindVertexArray(0);
 }
@@ -39,6 +39,8 @@ const char* resources::path(AssetId id) {
             return "resources/shaders/text_fragment.glsl";
         case AssetId::Fonts_Antonio_Bold:
             return "resources/fonts/Antonio-Bold.ttf";
+        case AssetId::Shaders_particle_update_vertex:
+            return "resources/shaders/particle_update_vertex.glsl";
         default:
             return nullptr;
     }
@@ -26,6 +26,7 @@ enum AssetId : unsigned int{
     Shaders_particle_fragment = 16,
     Shaders_text_fragment = 17,
     Fonts_Antonio_Bold = 18,
+    Shaders_particle_update_vertex = 19,
 };
 
 const char* path(AssetId id);
@@ -6,10 +6,19 @@ layout(location = 3) in ivec4 aBoneIDs;
 layout(location = 4) in vec4 aWeights;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 uniform mat4 bones[100];
 
+// Written once a frame; matches FrameUniforms in frame_uniforms.hpp
+layout(std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 viewport; // width, height, 1 / width, 1 / height
+    float time;
+    float deltaTime;
+};
+
 out vec3 FragPos;
 out vec3 Normal;
 
@@ -23,5 +32,5 @@ void main() {
     FragPos = vec3(model * pos);
     Normal = mat3(transpose(inverse(model * boneTransform))) * aNormal;
 
-    gl_Position = projection * view * model * pos;
+    gl_Position = viewProjection * model * pos;
 }
@@ -8,6 +8,10 @@ in vec2 TexCoord;
 #define MAX_LIGHTS 32
 #define PI 3.14159265359
 
+// Material features are compiled in rather than branched on: the renderer
+// builds one variant per combination of HAS_DIFFUSE_TEXTURE,
+// HAS_SPECULAR_TEXTURE and HAS_NORMAL_MAP it draws with
+
 struct PointLight {
     vec3 position;
     vec3 color;
@@ -34,14 +38,27 @@ uniform float roughness; // Surface roughness [0,1]
 uniform float metallic; // Metallic factor [0,1]
 uniform float alpha;
 uniform float shininess; // Ignored in PBR
-uniform int hasDiffuseTexture;
-uniform int hasSpecularTexture;
-uniform int hasNormalMap;
-uniform vec3 viewPos;
 
+// Written once a frame; matches FrameUniforms in frame_uniforms.hpp
+layout(std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 viewport; // width, height, 1 / width, 1 / height
+    float time;
+    float deltaTime;
+};
+
+#ifdef HAS_DIFFUSE_TEXTURE
 uniform sampler2D material_diffuse; // Albedo texture
+#endif
+#ifdef HAS_SPECULAR_TEXTURE
 uniform sampler2D material_specular; // Can be metallic or specular texture
+#endif
+#ifdef HAS_NORMAL_MAP
 uniform sampler2D material_normalMap;
+#endif
 
 // PBR Functions
 
@@ -136,23 +153,21 @@ vec3 calculatePBRDirectionalLight(DirectionalLight light, vec3 normal, vec3 view
 
 void main() {
     // Get material properties
-    vec3 albedo;
-    if (hasDiffuseTexture != 0) {
-        albedo = texture(material_diffuse, TexCoord).rgb * diffuseColor;
-    } else {
-        albedo = diffuseColor;
-    }
+#ifdef HAS_DIFFUSE_TEXTURE
+    vec3 albedo = texture(material_diffuse, TexCoord).rgb * diffuseColor;
+#else
+    vec3 albedo = diffuseColor;
+#endif
 
     // Get normal
-    vec3 norm;
-    if (hasNormalMap != 0) {
-        vec3 normalMap = texture(material_normalMap, TexCoord).rgb * 2.0 - 1.0;
-        norm = normalize(Normal + normalMap * 0.1);
-    } else {
-        norm = normalize(Normal);
-    }
+#ifdef HAS_NORMAL_MAP
+    vec3 normalMap = texture(material_normalMap, TexCoord).rgb * 2.0 - 1.0;
+    vec3 norm = normalize(Normal + normalMap * 0.1);
+#else
+    vec3 norm = normalize(Normal);
+#endif
 
-    vec3 viewDirection = normalize(viewPos - FragPos);
+    vec3 viewDirection = normalize(cameraPosition.xyz - FragPos);
 
     // PBR material setup
     float metallicValue = metallic;
@@ -162,13 +177,13 @@ void main() {
     vec3 F0 = mix(specularColor, albedo, metallicValue);
 
     // If specular texture is provided, use it to modulate F0 or metallic
-    if (hasSpecularTexture != 0) {
-        vec3 specularSample = texture(material_specular, TexCoord).rgb;
-        // Assume specular texture contains metallic in R channel, roughness in G channel
-        metallicValue *= specularSample.r;
-        roughnessValue *= specularSample.g;
-        F0 = mix(F0, albedo, metallicValue);
-    }
+#ifdef HAS_SPECULAR_TEXTURE
+    vec3 specularSample = texture(material_specular, TexCoord).rgb;
+    // Assume specular texture contains metallic in R channel, roughness in G channel
+    metallicValue *= specularSample.r;
+    roughnessValue *= specularSample.g;
+    F0 = mix(F0, albedo, metallicValue);
+#endif
 
     // Calculate lighting
     vec3 Lo = vec3(0.0);
@@ -0,0 +1,102 @@
+// particle_update_vertex.glsl
+// One vertex per particle slot, run with the rasterizer off. The outputs
+// are captured by transform feedback into the other half of the ping-pong
+// pair, and are laid out so the result can be drawn as instance data.
+#version 330 core
+layout(location = 0) in vec4 inPositionLife;  // xyz position, w seconds left
+layout(location = 1) in vec4 inVelocitySize;  // xyz velocity, w size at spawn
+layout(location = 2) in vec4 inColor;
+layout(location = 3) in vec4 inRender;        // x drawn size, y rotation, z spin
+
+out vec4 outPositionLife;
+out vec4 outVelocitySize;
+out vec4 outColor;
+out vec4 outRender;
+
+uniform float dt;
+uniform uint seed;
+
+// Dead slots in [spawnStart, spawnStart + spawnCount), wrapping at
+// capacity, start a new particle this step
+uniform int spawnStart;
+uniform int spawnCount;
+uniform int capacity;
+
+uniform vec3 spawnPosition;
+uniform vec3 spawnPositionVariance;
+uniform vec3 initialVelocity;
+uniform vec3 velocityVariance;
+uniform float particleLifetime;
+uniform float lifetimeVariance;
+uniform float startSize;
+uniform float endSize;
+uniform float sizeVariance;
+uniform vec4 startColor;
+uniform vec4 endColor;
+uniform vec3 gravity;
+uniform float damping;
+uniform float rotationSpeed;
+uniform float rotationVariance;
+
+// lowbias32 (Chris Wellons)
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+float random(inout uint state) {
+    state = hash(state);
+    return float(state >> 8) * (1.0 / 16777216.0);
+}
+
+float centered(inout uint state, float base, float variance) {
+    return base + (random(state) * 2.0 - 1.0) * variance;
+}
+
+vec3 centered(inout uint state, vec3 base, vec3 variance) {
+    float x = centered(state, base.x, variance.x);
+    float y = centered(state, base.y, variance.y);
+    float z = centered(state, base.z, variance.z);
+    return vec3(x, y, z);
+}
+
+void main() {
+    vec3 position = inPositionLife.xyz;
+    float life = inPositionLife.w;
+    vec3 velocity = inVelocitySize.xyz;
+    float size = inVelocitySize.w;
+    float rotation = inRender.y;
+    float spin = inRender.z;
+
+    bool due = (gl_VertexID - spawnStart + capacity) % capacity < spawnCount;
+    if (life <= 0.0 && due) {
+        uint state = hash(uint(gl_VertexID) ^ seed);
+        position = centered(state, spawnPosition, spawnPositionVariance);
+        velocity = centered(state, initialVelocity, velocityVariance);
+        life = centered(state, particleLifetime, lifetimeVariance);
+        size = centered(state, startSize, sizeVariance);
+        rotation = random(state) * 6.28318530718;
+        spin = centered(state, rotationSpeed, rotationVariance);
+    }
+
+    // Same integration as the CPU path, new particles included
+    if (life > 0.0) {
+        velocity = (velocity + gravity * dt) * damping;
+        position += velocity * dt;
+        rotation += spin * dt;
+        life -= dt;
+    }
+
+    // Dead slots draw as zero-sized quads, which rasterize nothing
+    float ratio = life / particleLifetime;
+    bool alive = life > 0.0;
+
+    outPositionLife = vec4(position, life);
+    outVelocitySize = vec4(velocity, size);
+    outColor = alive ? mix(endColor, startColor, ratio) : vec4(0.0);
+    outRender = vec4(alive ? mix(endSize, startSize, ratio) * size : 0.0, rotation, spin, 0.0);
+}
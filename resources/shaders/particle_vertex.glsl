@@ -10,8 +10,21 @@ layout(location = 5) in float aRotation;
 out vec2 TexCoord;
 out vec4 ParticleColor;
 
-uniform mat4 view;
-uniform mat4 projection;
+// Written once a frame; matches FrameUniforms in frame_uniforms.hpp
+layout(std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 viewport; // width, height, 1 / width, 1 / height
+    float time;
+    float deltaTime;
+};
+
+// Packed instances hold positions as 0..1 within the draw's bounds; full
+// precision instances get a zero origin and unit scale
+uniform vec3 instanceOrigin;
+uniform vec3 instanceScale;
 
 void main() {
     // Billboard the particle to face the camera
@@ -28,11 +41,11 @@ void main() {
         );
 
     // Scale and position the particle
-    vec3 worldPos = aWorldPos +
+    vec3 worldPos = instanceOrigin + aWorldPos * instanceScale +
             (CameraRight * rotatedPos.x * aSize) +
             (CameraUp * rotatedPos.y * aSize);
 
-    gl_Position = projection * view * vec4(worldPos, 1.0);
+    gl_Position = viewProjection * vec4(worldPos, 1.0);
 
     TexCoord = aTexCoord;
     ParticleColor = aColor;
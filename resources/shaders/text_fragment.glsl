@@ -1,12 +1,17 @@
 #version 330 core
 in vec2 TexCoords;
+in vec3 TextColor;
 out vec4 color;
 
 uniform sampler2D text;
-uniform vec3 textColor;
 
 void main()
 {
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
-    color = vec4(textColor, 1.0) * sampled;
+    // Distance field: 0.5 on the outline. fwidth is how much the field
+    // changes over one screen pixel, so the edge is ramped over about a
+    // pixel whatever size the text is drawn at.
+    float field = texture(text, TexCoords).r;
+    float width = max(fwidth(field) * 0.7, 1e-4);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, field);
+    color = vec4(TextColor, alpha);
 }
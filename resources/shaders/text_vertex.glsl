@@ -1,11 +1,24 @@
 #version 330 core
 layout(location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+layout(location = 1) in vec4 vertexColor;
 out vec2 TexCoords;
+out vec3 TextColor;
 
-uniform mat4 projection;
+// Written once a frame; matches FrameUniforms in frame_uniforms.hpp
+layout(std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 viewport; // width, height, 1 / width, 1 / height
+    float time;
+    float deltaTime;
+};
 
 void main()
 {
-    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
+    // Positions are in pixels from the bottom left of the window
+    gl_Position = vec4(vertex.xy * viewport.zw * 2.0 - 1.0, 0.0, 1.0);
     TexCoords = vertex.zw;
+    TextColor = vertexColor.rgb;
 }
@@ -9,8 +9,16 @@ out vec3 Normal;
 out vec2 TexCoord;
 
 // uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Written once a frame; matches FrameUniforms in frame_uniforms.hpp
+layout(std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 viewport; // width, height, 1 / width, 1 / height
+    float time;
+    float deltaTime;
+};
 
 
 void main()
@@ -19,5 +27,5 @@ void main()
     Normal = mat3(transpose(inverse(instanceMatrix))) * aNormal;
     TexCoord = aTexCoord;
     
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    gl_Position = viewProjection * vec4(FragPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// xoshiro128+ (Blackman & Vigna): 128 bits of state, a handful of adds,
+// shifts and xors per number. Plenty for effects and much cheaper than
+// std::mt19937 behind std::uniform_real_distribution.
+//
+// Rng4 runs four independent streams side by side. The state update is
+// the same operations on four lanes, which the compiler turns into SIMD,
+// and filling an array produces four floats per step.
+namespace rng_detail {
+
+inline uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+// splitmix64, to spread a small seed over the whole state
+inline uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Top 24 bits as a float in [0, 1)
+inline float to_unit_float(uint32_t x) { return static_cast<float>(x >> 8) * (1.0f / 16777216.0f); }
+
+} // namespace rng_detail
+
+class Rng4 {
+public:
+    explicit Rng4(uint64_t seed = 1) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        uint64_t x = seed;
+        for (int lane = 0; lane < 4; lane++) {
+            uint64_t a = rng_detail::splitmix64(x);
+            uint64_t b = rng_detail::splitmix64(x);
+            s0[lane] = static_cast<uint32_t>(a);
+            s1[lane] = static_cast<uint32_t>(a >> 32);
+            s2[lane] = static_cast<uint32_t>(b);
+            s3[lane] = static_cast<uint32_t>(b >> 32);
+        }
+    }
+
+    // Four uniform floats in [0, 1), one per stream
+    void next4(float out[4]) {
+        for (int lane = 0; lane < 4; lane++) {
+            uint32_t result = s0[lane] + s3[lane];
+            uint32_t t = s1[lane] << 9;
+            s2[lane] ^= s0[lane];
+            s3[lane] ^= s1[lane];
+            s1[lane] ^= s2[lane];
+            s0[lane] ^= s3[lane];
+            s2[lane] ^= t;
+            s3[lane] = rng_detail::rotl(s3[lane], 11);
+            out[lane] = rng_detail::to_unit_float(result);
+        }
+    }
+
+    float next() {
+        if (cursor == 4) {
+            next4(pending);
+            cursor = 0;
+        }
+        return pending[cursor++];
+    }
+
+    float range(float min, float max) { return min + next() * (max - min); }
+
+    // out[i] = base + [-variance, variance), for n values
+    void fill_centered(float* out, size_t n, float base, float variance) {
+        float scale = 2.0f * variance;
+        float offset = base - variance;
+        size_t i = 0;
+        float lanes[4];
+        for (; i + 4 <= n; i += 4) {
+            next4(lanes);
+            for (int lane = 0; lane < 4; lane++) out[i + lane] = offset + lanes[lane] * scale;
+        }
+        for (; i < n; i++) out[i] = offset + next() * scale;
+    }
+
+    void fill_range(float* out, size_t n, float min, float max) {
+        fill_centered(out, n, 0.5f * (min + max), 0.5f * (max - min));
+    }
+
+private:
+    alignas(16) uint32_t s0[4], s1[4], s2[4], s3[4];
+    float pending[4] = {};
+    int cursor = 4;
+};
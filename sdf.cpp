@@ -0,0 +1,114 @@
+#include "sdf.hpp"
+#include <algorithm>
+#include <cmath>
+
+static constexpr float FAR_AWAY = 1e20f;
+
+// Squared distance transform of one row or column (Felzenszwalb and
+// Huttenlocher): d[q] = min over p of (q - p)^2 + f[p], in linear time from
+// the lower envelope of the parabolas rooted at each p
+static void distance_transform_1d(const float* f, int n, float* d, int* v, float* z) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -FAR_AWAY;
+    z[1] = FAR_AWAY;
+    for (int q = 1; q < n; q++) {
+        // Drop parabolas that q's hides; FAR_AWAY is large enough that the
+        // intersection never passes z[0]
+        float s;
+        while (true) {
+            int p = v[k];
+            s = ((f[q] + q * q) - (f[p] + p * p)) / (2.0f * (q - p));
+            if (s > z[k]) break;
+            k--;
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = FAR_AWAY;
+    }
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q) k++;
+        float offset = static_cast<float>(q - v[k]);
+        d[q] = offset * offset + f[v[k]];
+    }
+}
+
+// Squared distance from every texel to the nearest one with grid == 0;
+// grid holds 0 for the feature and FAR_AWAY elsewhere and is overwritten
+static void distance_transform_2d(std::vector<float>& grid, int width, int height) {
+    int n = std::max(width, height);
+    std::vector<float> f(n), d(n), z(n + 1);
+    std::vector<int> v(n);
+
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) f[y] = grid[y * width + x];
+        distance_transform_1d(f.data(), height, d.data(), v.data(), z.data());
+        for (int y = 0; y < height; y++) grid[y * width + x] = d[y];
+    }
+    for (int y = 0; y < height; y++) {
+        float* row = &grid[y * width];
+        std::copy(row, row + width, f.begin());
+        distance_transform_1d(f.data(), width, row, v.data(), z.data());
+    }
+}
+
+void build_distance_field(const unsigned char* coverage, int width, int height, int pitch, int downsample,
+                          int spread, DistanceField& out) {
+    if (width == 0 || height == 0) {
+        // Nothing drawn, such as a space: no texels either
+        out = {};
+        return;
+    }
+
+    // Source grid padded so the field can fall off outside the outline, and
+    // rounded up to whole output texels
+    const int pad = spread * downsample;
+    const int outWidth = (width + downsample - 1) / downsample + 2 * spread;
+    const int outHeight = (height + downsample - 1) / downsample + 2 * spread;
+    const int gridWidth = outWidth * downsample;
+    const int gridHeight = outHeight * downsample;
+
+    auto inside = [&](int x, int y) {
+        x -= pad;
+        y -= pad;
+        return x >= 0 && y >= 0 && x < width && y < height && coverage[y * pitch + x] >= 128;
+    };
+
+    // Distance to the nearest inside texel, and to the nearest outside one
+    std::vector<float> toInside(static_cast<size_t>(gridWidth) * gridHeight);
+    std::vector<float> toOutside(toInside.size());
+    for (int y = 0; y < gridHeight; y++) {
+        for (int x = 0; x < gridWidth; x++) {
+            bool in = inside(x, y);
+            toInside[y * gridWidth + x] = in ? 0.0f : FAR_AWAY;
+            toOutside[y * gridWidth + x] = in ? FAR_AWAY : 0.0f;
+        }
+    }
+    distance_transform_2d(toInside, gridWidth, gridHeight);
+    distance_transform_2d(toOutside, gridWidth, gridHeight);
+
+    // The outline runs half a texel from the centres on either side of it
+    std::vector<float> signedDistance(toInside.size());
+    for (size_t i = 0; i < signedDistance.size(); i++) {
+        signedDistance[i] = toInside[i] == 0.0f ? std::sqrt(toOutside[i]) - 0.5f : 0.5f - std::sqrt(toInside[i]);
+    }
+
+    out.width = outWidth;
+    out.height = outHeight;
+    out.padding = spread;
+    out.pixels.resize(static_cast<size_t>(outWidth) * outHeight);
+    const float toOutputUnits = 1.0f / (downsample * downsample * downsample);
+    for (int oy = 0; oy < outHeight; oy++) {
+        for (int ox = 0; ox < outWidth; ox++) {
+            float sum = 0.0f;
+            for (int y = oy * downsample; y < (oy + 1) * downsample; y++) {
+                for (int x = ox * downsample; x < (ox + 1) * downsample; x++) sum += signedDistance[y * gridWidth + x];
+            }
+            float distance = sum * toOutputUnits;
+            float value = std::clamp(0.5f + distance / (2.0f * spread), 0.0f, 1.0f);
+            out.pixels[oy * outWidth + ox] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+        }
+    }
+}
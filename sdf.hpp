@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+
+// Single-channel signed distance field, one byte per texel: half way (0.5
+// once normalized) on the outline, rising inside the shape and falling
+// outside it, reaching 255 and 0 at spread texels from the outline.
+struct DistanceField {
+    int width = 0;
+    int height = 0;
+    int padding = 0; // texels added on every side of the source bitmap
+    std::vector<unsigned char> pixels;
+};
+
+// Builds the distance field of an 8-bit coverage bitmap (such as a FreeType
+// glyph), downsample times smaller than the source and padded by spread
+// texels so the falloff outside the outline fits. The source is expected
+// to be rendered that much larger than the field; distances are exact
+// Euclidean ones on the source grid, averaged down, so the outline keeps
+// sub-texel precision. An empty bitmap gives an empty field.
+void build_distance_field(const unsigned char* coverage, int width, int height, int pitch, int downsample,
+                          int spread, DistanceField& out);
+
+// Distance in field texels that a byte of DistanceField::pixels encodes,
+// positive inside
+inline float distance_field_decode(unsigned char value, int spread) {
+    return (value / 255.0f - 0.5f) * 2.0f * spread;
+}
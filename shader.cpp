@@ -1,11 +1,194 @@
 #include "shader.hpp"
+#include <algorithm>
 #include <map>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <string_view>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 #define INVALID_UNIFORM_LOCATION 0xffffffff
 
+// GL 4.1 / ARB_get_program_binary; loaded by hand since glad is generated for 3.3
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+typedef void (*GetProgramBinaryProc)(GLuint, GLsizei, GLsizei *, GLenum *, void *);
+typedef void (*ProgramBinaryProc)(GLuint, GLenum, const void *, GLsizei);
+typedef void (*ProgramParameteriProc)(GLuint, GLenum, GLint);
+
+// Linked programs are saved here, one file per program, named by the hash
+// of everything that went into them
+static const char *PROGRAM_CACHE_DIR = "shader_cache";
+static const char PROGRAM_CACHE_MAGIC[4] = {'P', 'B', 'I', 'N'};
+static constexpr uint32_t PROGRAM_CACHE_VERSION = 1;
+
+static Shader::CacheStats cacheStats;
+// Key of the last program buildProgram made, 0 without program binaries
+static uint64_t lastProgramKey = 0;
+
+// Uniform blocks, by name, that every program has pointed at a fixed binding
+static std::vector<std::pair<std::string, unsigned int>> sharedBlocks;
+
+static void bindSharedBlocks(unsigned int program)
+{
+    for (const auto &[name, binding] : sharedBlocks)
+    {
+        GLuint index = glGetUniformBlockIndex(program, name.c_str());
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(program, index, binding);
+    }
+}
+
+static struct
+{
+    bool checked = false;
+    bool available = false;
+    GetProgramBinaryProc getProgramBinary = nullptr;
+    ProgramBinaryProc programBinary = nullptr;
+    ProgramParameteriProc programParameteri = nullptr;
+} binaryApi;
+
+// Whether the driver can hand programs back; some (macOS among them)
+// expose the calls but no binary formats
+static bool programBinariesAvailable()
+{
+    if (binaryApi.checked)
+        return binaryApi.available;
+    binaryApi.checked = true;
+    binaryApi.getProgramBinary = (GetProgramBinaryProc)glfwGetProcAddress("glGetProgramBinary");
+    binaryApi.programBinary = (ProgramBinaryProc)glfwGetProcAddress("glProgramBinary");
+    binaryApi.programParameteri = (ProgramParameteriProc)glfwGetProcAddress("glProgramParameteri");
+    GLint formats = 0;
+    if (binaryApi.getProgramBinary && binaryApi.programBinary && binaryApi.programParameteri)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    binaryApi.available = formats > 0;
+    if (!binaryApi.available)
+        std::cout << "Shader: driver has no program binary formats, compiling every launch" << std::endl;
+    return binaryApi.available;
+}
+
+// FNV-1a over the program's sources and the driver that builds them, so a
+// driver update or an edited shader never picks up an old binary
+static uint64_t programKey(std::initializer_list<std::string_view> parts)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&](std::string_view text) {
+        for (unsigned char c : text)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        // Separator, so moving text between parts changes the key
+        hash ^= 0xff;
+        hash *= 1099511628211ull;
+    };
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+    {
+        const char *value = reinterpret_cast<const char *>(glGetString(name));
+        add(value ? value : "");
+    }
+    for (std::string_view part : parts)
+        add(part);
+    return hash;
+}
+
+static uint64_t sourceKey(const char *vertexSource, const char *fragmentSource, const char *const *varyings,
+                          int varyingCount)
+{
+    std::string varyingList;
+    for (int i = 0; i < varyingCount; i++)
+        varyingList += std::string(varyings[i]) + ",";
+    return programKey({vertexSource, fragmentSource ? fragmentSource : "", varyingList});
+}
+
+static std::string programCachePath(uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return std::string(PROGRAM_CACHE_DIR) + "/" + name;
+}
+
+// Loads a saved binary into program; false if there is none or the driver
+// refuses it, in which case the file is removed
+static bool loadProgramBinary(unsigned int program, uint64_t key)
+{
+    std::string path = programCachePath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    char magic[4];
+    uint32_t version = 0, format = 0, length = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    file.read(reinterpret_cast<char *>(&format), sizeof(format));
+    file.read(reinterpret_cast<char *>(&length), sizeof(length));
+    std::vector<char> binary;
+    bool valid = file && std::memcmp(magic, PROGRAM_CACHE_MAGIC, sizeof(magic)) == 0 &&
+                 version == PROGRAM_CACHE_VERSION && length > 0;
+    if (valid)
+    {
+        binary.resize(length);
+        file.read(binary.data(), length);
+        valid = static_cast<bool>(file);
+    }
+    file.close();
+
+    int success = 0;
+    if (valid)
+    {
+        binaryApi.programBinary(program, format, binary.data(), static_cast<GLsizei>(length));
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+    }
+    if (!success)
+    {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        cacheStats.rejected++;
+    }
+    return success;
+}
+
+static void storeProgramBinary(unsigned int program, uint64_t key)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    binaryApi.getProgramBinary(program, length, &length, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(PROGRAM_CACHE_DIR, error);
+    std::ofstream file(programCachePath(key), std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return;
+    uint32_t header[3] = {PROGRAM_CACHE_VERSION, format, static_cast<uint32_t>(length)};
+    file.write(PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC));
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    file.write(binary.data(), length);
+}
+
+
+// Errors from the compiles and links since it was last cleared
+static std::string buildLog;
 
 static bool checkCompileErrors(ShaderID shader, std::string type)
 {
@@ -19,6 +202,7 @@ static bool checkCompileErrors(ShaderID shader, std::string type)
             glGetShaderInfoLog(shader, 1024, NULL, infoLog);
             std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n"
                       << infoLog << std::endl;
+            buildLog += type + ": " + infoLog;
             return false;
         }
     }
@@ -30,6 +214,7 @@ static bool checkCompileErrors(ShaderID shader, std::string type)
             glGetProgramInfoLog(shader, 1024, NULL, infoLog);
             std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n"
                       << infoLog << std::endl;
+            buildLog += type + ": " + infoLog;
 
                       return false;
         }
@@ -101,32 +286,490 @@ GLint Shader::GetUniformLocation(unsigned int shader, const char *pUniformName)
     return Location;
 }
 
-unsigned int Shader::Create(const char *vPath, const char *fPath)
+// Program from a saved binary when there is a usable one, compiled and
+// linked (and saved) otherwise. Varyings, if any, are captured by
+// transform feedback; fragmentSource may then be null. Returns 0 if the
+// sources fail to compile or link.
+static unsigned int buildProgram(const char *vertexSource, const char *fragmentSource,
+                                 const char *const *varyings = nullptr, int varyingCount = 0)
 {
-    std::string vertexCode = readFile(vPath);
-    std::string fragmentCode = readFile(fPath);
-
-    const char *vShaderCode = vertexCode.c_str();
-    const char *fShaderCode = fragmentCode.c_str();
+    auto start = std::chrono::steady_clock::now();
+    cacheStats.programs++;
 
-    unsigned int vertex = compileShader(vShaderCode, GL_VERTEX_SHADER);
-    unsigned int fragment = compileShader(fShaderCode, GL_FRAGMENT_SHADER);
+    bool useCache = programBinariesAvailable();
+    uint64_t key = useCache ? sourceKey(vertexSource, fragmentSource, varyings, varyingCount) : 0;
+    lastProgramKey = key;
 
-    unsigned int ID;
+    unsigned int ID = glCreateProgram();
+    if (useCache && loadProgramBinary(ID, key))
+    {
+        bindSharedBlocks(ID);
+        cacheStats.fromCache++;
+        cacheStats.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return ID;
+    }
+    // A refused binary can leave the program in any state
+    glDeleteProgram(ID);
     ID = glCreateProgram();
+
+    unsigned int vertex = compileShader(vertexSource, GL_VERTEX_SHADER);
+    unsigned int fragment = fragmentSource ? compileShader(fragmentSource, GL_FRAGMENT_SHADER) : 0;
     glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
+    if (fragment)
+        glAttachShader(ID, fragment);
+    // Has to be set before linking
+    if (varyingCount > 0)
+        glTransformFeedbackVaryings(ID, varyingCount, varyings, GL_INTERLEAVED_ATTRIBS);
+    if (useCache)
+        binaryApi.programParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(ID);
     bool success = checkCompileErrors(ID, "PROGRAM");
 
+    glDeleteShader(vertex);
+    if (fragment)
+        glDeleteShader(fragment);
+
+    if (!success)
+    {
+        glDeleteProgram(ID);
+        return 0;
+    }
+    if (useCache)
+        storeProgramBinary(ID, key);
+    bindSharedBlocks(ID);
+    cacheStats.compiled++;
+    cacheStats.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ID;
+}
+
+// Programs built from files, relinked in place when a file changes so
+// every copy of the id stays valid
+struct WatchedProgram
+{
+    unsigned int id;
+    std::string vertexPath;
+    std::string fragmentPath; // empty for transform feedback programs
+    std::vector<std::string> varyings;
+    std::string defines;
+    uint64_t key; // of its saved binary, 0 without program binaries
+    std::string error; // from the last reload, empty if it worked
+};
+static std::vector<WatchedProgram> watchedPrograms;
+static uint32_t reloadCount = 0;
+
+static std::string normalPath(const std::string &path)
+{
+    std::error_code error;
+    std::filesystem::path normal = std::filesystem::weakly_canonical(path, error);
+    return error ? path : normal.string();
+}
 
+#ifdef __linux__
+// Directories are watched rather than files: editors often save by
+// writing a new file and renaming it over the old one, which a watch on
+// the file itself would not survive
+static int watchFd = -1;
+static std::map<int, std::string> watchedDirectories;
+
+static void watchFile(const std::string &path)
+{
+    if (watchFd < 0)
+        watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watchFd < 0)
+        return;
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    for (const auto &[wd, watchedDirectory] : watchedDirectories)
+        if (watchedDirectory == directory)
+            return;
+    int wd = inotify_add_watch(watchFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd >= 0)
+        watchedDirectories[wd] = directory;
+}
+
+// Files written since the last call; never waits for one
+static std::vector<std::string> changedFiles()
+{
+    std::vector<std::string> changed;
+    if (watchFd < 0)
+        return changed;
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = read(watchFd, buffer, sizeof(buffer))) > 0)
+    {
+        for (char *at = buffer; at < buffer + length;)
+        {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(at);
+            auto directory = watchedDirectories.find(event->wd);
+            if (event->len > 0 && directory != watchedDirectories.end())
+                changed.push_back(directory->second + "/" + event->name);
+            at += sizeof(inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
+#else
+// Without inotify the watched files' modification times are compared,
+// a few times a second at most
+static std::map<std::string, std::filesystem::file_time_type> watchedFiles;
+
+static void watchFile(const std::string &path)
+{
+    std::error_code error;
+    watchedFiles[path] = std::filesystem::last_write_time(path, error);
+}
+
+static std::vector<std::string> changedFiles()
+{
+    std::vector<std::string> changed;
+    static auto lastCheck = std::chrono::steady_clock::now();
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastCheck < std::chrono::milliseconds(250))
+        return changed;
+    lastCheck = now;
+    for (auto &[path, modified] : watchedFiles)
+    {
+        std::error_code error;
+        auto time = std::filesystem::last_write_time(path, error);
+        if (!error && time != modified)
+        {
+            modified = time;
+            changed.push_back(path);
+        }
+    }
+    return changed;
+}
+#endif
+
+// Defines go straight after #version, which has to stay the first line
+static std::string injectDefines(const std::string &source, const std::string &defines)
+{
+    if (defines.empty() || source.empty())
+        return source;
+    size_t lineEnd = source.compare(0, 8, "#version") == 0 ? source.find('\n') : std::string::npos;
+    if (lineEnd == std::string::npos)
+        return defines + source;
+    return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+static void watchProgram(unsigned int id, const char *vertexPath, const char *fragmentPath,
+                         const char *const *varyings, int varyingCount, const std::string &defines)
+{
+    // Ids of deleted programs get handed out again
+    std::erase_if(watchedPrograms, [&](const WatchedProgram &program) { return program.id == id; });
+    WatchedProgram program{id, normalPath(vertexPath), fragmentPath ? normalPath(fragmentPath) : "", {},
+                           defines, lastProgramKey, ""};
+    for (int i = 0; i < varyingCount; i++)
+        program.varyings.push_back(varyings[i]);
+    watchFile(program.vertexPath);
+    if (!program.fragmentPath.empty())
+        watchFile(program.fragmentPath);
+    watchedPrograms.push_back(std::move(program));
+}
+
+// One uniform, or one element of a uniform array, and its value
+struct SavedUniform
+{
+    std::string name;
+    GLenum type;
+    GLint location;
+    union
+    {
+        GLfloat f[16];
+        GLint i[16];
+        GLuint u[16];
+    } value;
+};
+
+static std::vector<SavedUniform> activeUniforms(unsigned int program)
+{
+    std::vector<SavedUniform> uniforms;
+    GLint count = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    for (GLint index = 0; index < count; index++)
+    {
+        char name[256];
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, index, sizeof(name), nullptr, &size, &type, name);
+        std::string base = name;
+        if (base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0)
+            base.resize(base.size() - 3);
+        for (GLint element = 0; element < size; element++)
+        {
+            SavedUniform uniform{size > 1 ? base + "[" + std::to_string(element) + "]" : base, type, -1, {}};
+            uniform.location = glGetUniformLocation(program, uniform.name.c_str());
+            // Members of uniform blocks have no location; their buffers keep them
+            if (uniform.location >= 0)
+                uniforms.push_back(uniform);
+        }
+    }
+    return uniforms;
+}
+
+static std::vector<SavedUniform> saveUniforms(unsigned int program)
+{
+    std::vector<SavedUniform> uniforms = activeUniforms(program);
+    for (SavedUniform &uniform : uniforms)
+    {
+        switch (uniform.type)
+        {
+        case GL_FLOAT: case GL_FLOAT_VEC2: case GL_FLOAT_VEC3: case GL_FLOAT_VEC4:
+        case GL_FLOAT_MAT2: case GL_FLOAT_MAT3: case GL_FLOAT_MAT4:
+        case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT3x2:
+        case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x2: case GL_FLOAT_MAT4x3:
+            glGetUniformfv(program, uniform.location, uniform.value.f);
+            break;
+        case GL_UNSIGNED_INT: case GL_UNSIGNED_INT_VEC2: case GL_UNSIGNED_INT_VEC3: case GL_UNSIGNED_INT_VEC4:
+            glGetUniformuiv(program, uniform.location, uniform.value.u);
+            break;
+        default: // ints, bools and samplers
+            glGetUniformiv(program, uniform.location, uniform.value.i);
+            break;
+        }
+    }
+    return uniforms;
+}
+
+// Sets the values saved from the old program on the uniforms of the new
+// one that kept their name and type; the program has to be in use
+static void restoreUniforms(unsigned int program, const std::vector<SavedUniform> &saved)
+{
+    std::map<std::string, const SavedUniform *> byName;
+    for (const SavedUniform &uniform : saved)
+        byName[uniform.name] = &uniform;
+    for (const SavedUniform &uniform : activeUniforms(program))
+    {
+        auto old = byName.find(uniform.name);
+        if (old == byName.end() || old->second->type != uniform.type)
+            continue;
+        const auto &value = old->second->value;
+        GLint location = uniform.location;
+        switch (uniform.type)
+        {
+        case GL_FLOAT: glUniform1fv(location, 1, value.f); break;
+        case GL_FLOAT_VEC2: glUniform2fv(location, 1, value.f); break;
+        case GL_FLOAT_VEC3: glUniform3fv(location, 1, value.f); break;
+        case GL_FLOAT_VEC4: glUniform4fv(location, 1, value.f); break;
+        case GL_FLOAT_MAT2: glUniformMatrix2fv(location, 1, GL_FALSE, value.f); break;
+        case GL_FLOAT_MAT3: glUniformMatrix3fv(location, 1, GL_FALSE, value.f); break;
+        case GL_FLOAT_MAT4: glUniformMatrix4fv(location, 1, GL_FALSE, value.f); break;
+        case GL_FLOAT_MAT2x3: glUniformMatrix2x3fv(location, 1, GL_FALSE, value.f); break;
+        case GL_FLOAT_MAT2x4: glUniformMatrix2x4fv(location, 1, GL_FALSE, value.f); break;
+        case GL_FLOAT_MAT3x2: glUniformMatrix3x2fv(location, 1, GL_FALSE, value.f); break;
+        case GL_FLOAT_MAT3x4: glUniformMatrix3x4fv(location, 1, GL_FALSE, value.f); break;
+        case GL_FLOAT_MAT4x2: glUniformMatrix4x2fv(location, 1, GL_FALSE, value.f); break;
+        case GL_FLOAT_MAT4x3: glUniformMatrix4x3fv(location, 1, GL_FALSE, value.f); break;
+        case GL_UNSIGNED_INT: glUniform1uiv(location, 1, value.u); break;
+        case GL_UNSIGNED_INT_VEC2: glUniform2uiv(location, 1, value.u); break;
+        case GL_UNSIGNED_INT_VEC3: glUniform3uiv(location, 1, value.u); break;
+        case GL_UNSIGNED_INT_VEC4: glUniform4uiv(location, 1, value.u); break;
+        case GL_INT_VEC2: case GL_BOOL_VEC2: glUniform2iv(location, 1, value.i); break;
+        case GL_INT_VEC3: case GL_BOOL_VEC3: glUniform3iv(location, 1, value.i); break;
+        case GL_INT_VEC4: case GL_BOOL_VEC4: glUniform4iv(location, 1, value.i); break;
+        default: glUniform1iv(location, 1, value.i); break;
+        }
+    }
+}
+
+// Uniform block bindings are program state too and go with a relink
+static std::vector<std::pair<std::string, GLint>> saveBlockBindings(unsigned int program)
+{
+    std::vector<std::pair<std::string, GLint>> bindings;
+    GLint count = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    for (GLint index = 0; index < count; index++)
+    {
+        char name[256];
+        GLint binding = 0;
+        glGetActiveUniformBlockName(program, index, sizeof(name), nullptr, name);
+        glGetActiveUniformBlockiv(program, index, GL_UNIFORM_BLOCK_BINDING, &binding);
+        bindings.push_back({name, binding});
+    }
+    return bindings;
+}
+
+// Builds the program's current sources; the running program is only
+// touched once they are known to compile and link
+static bool reloadProgram(WatchedProgram &program)
+{
+    buildLog.clear();
+    std::string vertexCode = injectDefines(readFile(program.vertexPath.c_str()), program.defines);
+    std::string fragmentCode =
+        program.fragmentPath.empty() ? "" : injectDefines(readFile(program.fragmentPath.c_str()), program.defines);
+    std::vector<const char *> varyings;
+    for (const std::string &varying : program.varyings)
+        varyings.push_back(varying.c_str());
+
+    unsigned int vertex = compileShader(vertexCode.c_str(), GL_VERTEX_SHADER);
+    unsigned int fragment = program.fragmentPath.empty() ? 0 : compileShader(fragmentCode.c_str(), GL_FRAGMENT_SHADER);
+    auto attach = [&](unsigned int target) {
+        glAttachShader(target, vertex);
+        if (fragment)
+            glAttachShader(target, fragment);
+        if (!varyings.empty())
+            glTransformFeedbackVaryings(target, static_cast<GLsizei>(varyings.size()), varyings.data(),
+                                        GL_INTERLEAVED_ATTRIBS);
+        glLinkProgram(target);
+    };
+
+    unsigned int scratch = glCreateProgram();
+    attach(scratch);
+    bool success = vertexCode.size() > 0 && (program.fragmentPath.empty() || fragmentCode.size() > 0) &&
+                   checkCompileErrors(scratch, "PROGRAM");
+    glDeleteProgram(scratch);
+
+    if (success)
+    {
+        // Relinking the same object with the same shaders can't fail now
+        std::vector<SavedUniform> uniforms = saveUniforms(program.id);
+        std::vector<std::pair<std::string, GLint>> blockBindings = saveBlockBindings(program.id);
+
+        GLuint attached[2];
+        GLsizei attachedCount = 0;
+        glGetAttachedShaders(program.id, 2, &attachedCount, attached);
+        for (GLsizei i = 0; i < attachedCount; i++)
+            glDetachShader(program.id, attached[i]);
+        attach(program.id);
+        success = checkCompileErrors(program.id, "PROGRAM");
+        glDetachShader(program.id, vertex);
+        if (fragment)
+            glDetachShader(program.id, fragment);
+
+        GLint current = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+        glUseProgram(program.id);
+        restoreUniforms(program.id, uniforms);
+        glUseProgram(current);
+        for (const auto &[name, binding] : blockBindings)
+        {
+            GLuint index = glGetUniformBlockIndex(program.id, name.c_str());
+            if (index != GL_INVALID_INDEX)
+                glUniformBlockBinding(program.id, index, binding);
+        }
+        bindSharedBlocks(program.id);
+
+        if (success && programBinariesAvailable())
+        {
+            uint64_t key = sourceKey(vertexCode.c_str(), program.fragmentPath.empty() ? nullptr : fragmentCode.c_str(),
+                                     varyings.data(), static_cast<int>(varyings.size()));
+            // The old sources' binary would never be loaded again, unless
+            // another watched program was built from them too
+            bool shared = std::any_of(watchedPrograms.begin(), watchedPrograms.end(), [&](const WatchedProgram &other) {
+                return &other != &program && other.key == program.key;
+            });
+            if (program.key != 0 && program.key != key && !shared)
+            {
+                std::error_code error;
+                std::filesystem::remove(programCachePath(program.key), error);
+            }
+            program.key = key;
+            storeProgramBinary(program.id, key);
+        }
+    }
     glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    if (fragment)
+        glDeleteShader(fragment);
 
-    if(!success) {
-        exit(1) ;
+    if (success)
+    {
+        program.error.clear();
+        reloadCount++;
+        std::cout << "Shader: reloaded " << program.vertexPath
+                  << (program.fragmentPath.empty() ? "" : " + " + program.fragmentPath) << std::endl;
+    }
+    else
+    {
+        program.error = program.vertexPath + (program.fragmentPath.empty() ? "" : " + " + program.fragmentPath) +
+                        ":\n" + (buildLog.empty() ? "could not read the source" : buildLog);
+        std::cerr << "Shader: keeping the old program, " << program.error << std::endl;
     }
+    return success;
+}
+
+bool Shader::ReloadChanged()
+{
+    std::vector<std::string> changed = changedFiles();
+    if (changed.empty())
+        return false;
+    for (std::string &path : changed)
+        path = normalPath(path);
+
+    // Programs deleted by their owners are forgotten
+    std::erase_if(watchedPrograms, [](const WatchedProgram &program) { return !glIsProgram(program.id); });
+    bool rebuilt = false;
+    for (WatchedProgram &program : watchedPrograms)
+    {
+        bool edited = false;
+        for (const std::string &path : changed)
+            edited = edited || path == program.vertexPath || path == program.fragmentPath;
+        if (edited)
+        {
+            reloadProgram(program);
+            rebuilt = true;
+        }
+    }
+    return rebuilt;
+}
+
+uint32_t Shader::ReloadCount()
+{
+    return reloadCount;
+}
+
+std::string Shader::ReloadErrors()
+{
+    std::string errors;
+    for (const WatchedProgram &program : watchedPrograms)
+        if (!program.error.empty())
+            errors += program.error + "\n";
+    return errors;
+}
+
+unsigned int Shader::Create(const char *vPath, const char *fPath, const std::string &defines)
+{
+    std::string vertexCode = injectDefines(readFile(vPath), defines);
+    std::string fragmentCode = injectDefines(readFile(fPath), defines);
+    unsigned int ID = CreateFromSource(vertexCode.c_str(), fragmentCode.c_str());
+    watchProgram(ID, vPath, fPath, nullptr, 0, defines);
+    return ID;
+}
 
+unsigned int Shader::CreateFromSource(const char *vertexSource, const char *fragmentSource)
+{
+    unsigned int ID = buildProgram(vertexSource, fragmentSource);
+    if(!ID) {
+        exit(1) ;
+    }
+    return ID;
+}
 
+unsigned int Shader::CreateTransformFeedback(const char *vPath, const char *const *varyings, int varyingCount)
+{
+    std::string vertexCode = readFile(vPath);
+    unsigned int ID = buildProgram(vertexCode.c_str(), nullptr, varyings, varyingCount);
+    if(!ID) {
+        exit(1) ;
+    }
+    watchProgram(ID, vPath, nullptr, varyings, varyingCount, "");
     return ID;
 }
+
+const Shader::CacheStats &Shader::GetCacheStats()
+{
+    return cacheStats;
+}
+
+void Shader::CopyUniforms(unsigned int from, unsigned int to)
+{
+    std::vector<SavedUniform> uniforms = saveUniforms(from);
+    GLint current = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+    glUseProgram(to);
+    restoreUniforms(to, uniforms);
+    glUseProgram(current);
+}
+
+void Shader::BindUniformBlock(const std::string &block, unsigned int binding)
+{
+    sharedBlocks.push_back({block, binding});
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "mygl.h"
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <string>
 
 #define ShaderID unsigned int
@@ -8,7 +9,16 @@
 namespace Shader
 {
 
-    unsigned int Create(const char *vPath, const char *fPath);
+    // Programs are built once per driver and set of sources: the linked
+    // binary is saved under shader_cache/ and loaded instead of compiling
+    // on later launches, falling back to compiling if the driver rejects it.
+    // defines ("#define NAME\n" lines) go after the #version line of both
+    // stages, so one pair of files can be built several ways.
+    unsigned int Create(const char *vPath, const char *fPath, const std::string &defines = "");
+    unsigned int CreateFromSource(const char *vertexSource, const char *fragmentSource);
+    // Vertex-only program whose outputs are captured, interleaved, by
+    // transform feedback
+    unsigned int CreateTransformFeedback(const char *vPath, const char *const *varyings, int varyingCount);
     void Use(unsigned int ID);
     void SetBool(const std::string &name, unsigned int ID, bool value);
     void SetInt(const std::string &name, unsigned int ID, int value);
@@ -16,4 +26,32 @@ namespace Shader
     void SetVec3(const std::string &name, unsigned int ID, const glm::vec3 &value);
     void SetMat4(const std::string &name, unsigned int ID, const glm::mat4 &mat);
     GLint GetUniformLocation(unsigned int shader, const char *pUniformName);
+    // Sets each uniform of to from the one of the same name and type in from
+    void CopyUniforms(unsigned int from, unsigned int to);
+    // Every program built from now on, or reloaded, that declares the
+    // uniform block has it read from this binding point
+    void BindUniformBlock(const std::string &block, unsigned int binding);
+
+    // Programs made with Create and CreateTransformFeedback are watched:
+    // when a source file changes the program is rebuilt between frames,
+    // keeping its id and uniform values. If the new source fails to
+    // compile or link the old program stays and the error is reported.
+    // Call once a frame on the GL thread; it never waits on the watcher.
+    // True if any program was rebuilt, or failed to be.
+    bool ReloadChanged();
+    // Bumped on every reload, since uniform locations may have moved
+    uint32_t ReloadCount();
+    // Errors of the programs whose last reload failed, empty if none
+    std::string ReloadErrors();
+
+    // Every program built so far and the time spent building them
+    struct CacheStats
+    {
+        int programs = 0;
+        int fromCache = 0;
+        int compiled = 0;
+        int rejected = 0; // saved binaries the driver refused
+        double milliseconds = 0.0;
+    };
+    const CacheStats &GetCacheStats();
 };
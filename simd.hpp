@@ -0,0 +1,157 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+// Minimal 4-wide float SIMD wrapper. SSE2 on x86, NEON on arm64 (Apple
+// Silicon) and a plain scalar fallback everywhere else, so kernels are
+// written once. Define SIMD_FORCE_SCALAR to check the fallback path.
+#if !defined(SIMD_FORCE_SCALAR) && (defined(__SSE2__) || defined(_M_X64))
+#define SIMD_SSE 1
+#include <emmintrin.h>
+#elif !defined(SIMD_FORCE_SCALAR) && defined(__ARM_NEON) && defined(__aarch64__)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#else
+#define SIMD_SCALAR 1
+#include <cstring>
+#endif
+
+namespace simd {
+
+#if SIMD_SSE
+
+struct f32x4 { __m128 v; };
+
+inline f32x4 load(const float* p) { return {_mm_loadu_ps(p)}; }
+inline void store(float* p, f32x4 a) { _mm_storeu_ps(p, a.v); }
+inline f32x4 set1(float x) { return {_mm_set1_ps(x)}; }
+inline f32x4 set(float a, float b, float c, float d) { return {_mm_setr_ps(a, b, c, d)}; }
+inline f32x4 zero() { return {_mm_setzero_ps()}; }
+
+inline f32x4 operator+(f32x4 a, f32x4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline f32x4 operator-(f32x4 a, f32x4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline f32x4 operator*(f32x4 a, f32x4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline f32x4 operator/(f32x4 a, f32x4 b) { return {_mm_div_ps(a.v, b.v)}; }
+inline f32x4 min(f32x4 a, f32x4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline f32x4 max(f32x4 a, f32x4 b) { return {_mm_max_ps(a.v, b.v)}; }
+inline f32x4 abs(f32x4 a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+
+// Comparisons return all-ones / all-zero lanes; bit_or / bit_and / select
+// are only meant to combine and consume such masks
+inline f32x4 cmplt(f32x4 a, f32x4 b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+inline f32x4 cmple(f32x4 a, f32x4 b) { return {_mm_cmple_ps(a.v, b.v)}; }
+inline f32x4 bit_or(f32x4 a, f32x4 b) { return {_mm_or_ps(a.v, b.v)}; }
+inline f32x4 bit_and(f32x4 a, f32x4 b) { return {_mm_and_ps(a.v, b.v)}; }
+inline f32x4 select(f32x4 mask, f32x4 a, f32x4 b) {
+    return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+}
+// Bit i set when lane i of mask is set
+inline int movemask(f32x4 mask) { return _mm_movemask_ps(mask.v); }
+
+inline void transpose4(f32x4& r0, f32x4& r1, f32x4& r2, f32x4& r3) {
+    _MM_TRANSPOSE4_PS(r0.v, r1.v, r2.v, r3.v);
+}
+
+#elif SIMD_NEON
+
+struct f32x4 { float32x4_t v; };
+
+inline f32x4 load(const float* p) { return {vld1q_f32(p)}; }
+inline void store(float* p, f32x4 a) { vst1q_f32(p, a.v); }
+inline f32x4 set1(float x) { return {vdupq_n_f32(x)}; }
+inline f32x4 set(float a, float b, float c, float d) {
+    const float lanes[4] = {a, b, c, d};
+    return {vld1q_f32(lanes)};
+}
+inline f32x4 zero() { return {vdupq_n_f32(0.0f)}; }
+
+inline f32x4 operator+(f32x4 a, f32x4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline f32x4 operator-(f32x4 a, f32x4 b) { return {vsubq_f32(a.v, b.v)}; }
+inline f32x4 operator*(f32x4 a, f32x4 b) { return {vmulq_f32(a.v, b.v)}; }
+inline f32x4 operator/(f32x4 a, f32x4 b) { return {vdivq_f32(a.v, b.v)}; }
+inline f32x4 min(f32x4 a, f32x4 b) { return {vminq_f32(a.v, b.v)}; }
+inline f32x4 max(f32x4 a, f32x4 b) { return {vmaxq_f32(a.v, b.v)}; }
+inline f32x4 abs(f32x4 a) { return {vabsq_f32(a.v)}; }
+
+inline f32x4 cmplt(f32x4 a, f32x4 b) { return {vreinterpretq_f32_u32(vcltq_f32(a.v, b.v))}; }
+inline f32x4 cmple(f32x4 a, f32x4 b) { return {vreinterpretq_f32_u32(vcleq_f32(a.v, b.v))}; }
+inline f32x4 bit_or(f32x4 a, f32x4 b) {
+    return {vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)))};
+}
+inline f32x4 bit_and(f32x4 a, f32x4 b) {
+    return {vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)))};
+}
+inline f32x4 select(f32x4 mask, f32x4 a, f32x4 b) {
+    return {vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v)};
+}
+inline int movemask(f32x4 mask) {
+    static const int32_t shifts[4] = {0, 1, 2, 3};
+    uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(mask.v), 31);
+    return static_cast<int>(vaddvq_u32(vshlq_u32(bits, vld1q_s32(shifts))));
+}
+
+inline void transpose4(f32x4& r0, f32x4& r1, f32x4& r2, f32x4& r3) {
+    float32x4x2_t t01 = vtrnq_f32(r0.v, r1.v);
+    float32x4x2_t t23 = vtrnq_f32(r2.v, r3.v);
+    r0.v = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    r1.v = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    r2.v = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3.v = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+#else
+
+struct f32x4 { float v[4]; };
+
+inline f32x4 load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void store(float* p, f32x4 a) { for (int i = 0; i < 4; i++) p[i] = a.v[i]; }
+inline f32x4 set1(float x) { return {{x, x, x, x}}; }
+inline f32x4 set(float a, float b, float c, float d) { return {{a, b, c, d}}; }
+inline f32x4 zero() { return set1(0.0f); }
+
+#define SIMD_SCALAR_OP(expr) f32x4 r; for (int i = 0; i < 4; i++) r.v[i] = (expr); return r
+inline f32x4 operator+(f32x4 a, f32x4 b) { SIMD_SCALAR_OP(a.v[i] + b.v[i]); }
+inline f32x4 operator-(f32x4 a, f32x4 b) { SIMD_SCALAR_OP(a.v[i] - b.v[i]); }
+inline f32x4 operator*(f32x4 a, f32x4 b) { SIMD_SCALAR_OP(a.v[i] * b.v[i]); }
+inline f32x4 operator/(f32x4 a, f32x4 b) { SIMD_SCALAR_OP(a.v[i] / b.v[i]); }
+inline f32x4 min(f32x4 a, f32x4 b) { SIMD_SCALAR_OP(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+inline f32x4 max(f32x4 a, f32x4 b) { SIMD_SCALAR_OP(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+inline f32x4 abs(f32x4 a) { SIMD_SCALAR_OP(std::fabs(a.v[i])); }
+
+inline float lane_mask(bool set) {
+    uint32_t bits = set ? 0xffffffffu : 0u;
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+inline uint32_t lane_bits(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+inline f32x4 cmplt(f32x4 a, f32x4 b) { SIMD_SCALAR_OP(lane_mask(a.v[i] < b.v[i])); }
+inline f32x4 cmple(f32x4 a, f32x4 b) { SIMD_SCALAR_OP(lane_mask(a.v[i] <= b.v[i])); }
+inline f32x4 bit_or(f32x4 a, f32x4 b) { SIMD_SCALAR_OP(lane_mask((lane_bits(a.v[i]) | lane_bits(b.v[i])) != 0)); }
+inline f32x4 bit_and(f32x4 a, f32x4 b) { SIMD_SCALAR_OP(lane_mask((lane_bits(a.v[i]) & lane_bits(b.v[i])) != 0)); }
+inline f32x4 select(f32x4 mask, f32x4 a, f32x4 b) { SIMD_SCALAR_OP(lane_bits(mask.v[i]) ? a.v[i] : b.v[i]); }
+#undef SIMD_SCALAR_OP
+
+inline int movemask(f32x4 mask) {
+    int bits = 0;
+    for (int i = 0; i < 4; i++) bits |= (lane_bits(mask.v[i]) >> 31) << i;
+    return bits;
+}
+
+inline void transpose4(f32x4& r0, f32x4& r1, f32x4& r2, f32x4& r3) {
+    f32x4 in[4] = {r0, r1, r2, r3};
+    f32x4* out[4] = {&r0, &r1, &r2, &r3};
+    for (int r = 0; r < 4; r++)
+        for (int c = 0; c < 4; c++) out[r]->v[c] = in[c].v[r];
+}
+
+#endif
+
+// a * b + c
+inline f32x4 madd(f32x4 a, f32x4 b, f32x4 c) { return a * b + c; }
+
+} // namespace simd
@@ -4,6 +4,7 @@
 
 #include <string>
 #include "mygl.h"
+#include "shader.hpp"
 #include <iostream>
 #include <cmath>
 #include "lib/stb_image.h"
@@ -35,12 +36,21 @@ private:
 
         out vec2 TexCoords;
 
-        uniform mat4 projection;
-        uniform mat4 view;
+        // Written once a frame; matches FrameUniforms in frame_uniforms.hpp
+        layout(std140) uniform FrameUniforms {
+            mat4 view;
+            mat4 projection;
+            mat4 viewProjection;
+            vec4 cameraPosition;
+            vec4 viewport;
+            float time;
+            float deltaTime;
+        };
 
         void main() {
             TexCoords = aTexCoord;
-            vec4 pos = projection * view * vec4(aPos, 1.0);
+            // Rotation only, so the dome stays centred on the camera
+            vec4 pos = projection * mat4(mat3(view)) * vec4(aPos, 1.0);
             gl_Position = pos.xyww;
         }
     )";
@@ -58,44 +68,6 @@ private:
         }
     )";
 
-    GLuint compileShader(const char* source, GLenum type) {
-        GLuint shader = glCreateShader(type);
-        glShaderSource(shader, 1, &source, nullptr);
-        glCompileShader(shader);
-
-        GLint success;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-        if (!success) {
-            char infoLog[512];
-            glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-            std::cerr << "Shader compilation failed: " << infoLog << std::endl;
-        }
-        return shader;
-    }
-
-    GLuint createShaderProgram() {
-        GLuint vertexShader = compileShader(vertexShaderSource, GL_VERTEX_SHADER);
-        GLuint fragmentShader = compileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
-
-        GLuint program = glCreateProgram();
-        glAttachShader(program, vertexShader);
-        glAttachShader(program, fragmentShader);
-        glLinkProgram(program);
-
-        GLint success;
-        glGetProgramiv(program, GL_LINK_STATUS, &success);
-        if (!success) {
-            char infoLog[512];
-            glGetProgramInfoLog(program, 512, nullptr, infoLog);
-            std::cerr << "Shader program linking failed: " << infoLog << std::endl;
-        }
-
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
-
-        return program;
-    }
-
     GLuint loadTexture(const std::string& path) {
         GLuint textureID;
         glGenTextures(1, &textureID);
@@ -201,7 +173,7 @@ public:
     // Constructor takes a single sky texture path
     SkyDome(const std::string& skyTexturePath, float radius = 100.0f, int rings = 16, int sectors = 32) {
         textureID = loadTexture(skyTexturePath);
-        shaderProgram = createShaderProgram();
+        shaderProgram = Shader::CreateFromSource(vertexShaderSource, fragmentShaderSource);
         generateDome(radius, rings, sectors);
     }
 
@@ -213,23 +185,13 @@ public:
         glDeleteProgram(shaderProgram);
     }
 
-    // Render function - takes glm matrices
-    void render(const glm::mat4& view, const glm::mat4& projection) {
+    // Render function - the matrices come from the frame's uniform block
+    void render() {
         // Change depth function so depth test passes when values are equal to depth buffer's content
         glDepthFunc(GL_LEQUAL);
 
         glUseProgram(shaderProgram);
 
-        // Remove translation from view matrix (keep only rotation)
-        glm::mat4 viewNoTranslation = glm::mat4(glm::mat3(view));
-
-        // Set uniforms
-        GLint viewLoc = glGetUniformLocation(shaderProgram, "view");
-        GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
-
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(viewNoTranslation));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
         // Bind texture and VAO
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, textureID);
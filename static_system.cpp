@@ -2,6 +2,7 @@
 #include "Input.hpp"
 #include "aabb_renderer.hpp"
 #include "camera.hpp"
+#include "heightfield.hpp"
 #include "model.hpp"
 #include "model_loader.hpp"
 #include "model_setup.hpp"
@@ -9,6 +10,9 @@
 #include "resource_ids.hpp"
 #include "skydome.hpp"
 #include "text_renderer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
 #include <glm/glm.hpp>
 #include <iostream>
@@ -49,6 +53,50 @@ static Mode current_mode = AABB_TRANSLATE;
 static Dimension current_dimension = X;
 
 static AABBRenderer* renderer = nullptr;
+static TextMesh* overlay = nullptr;
+
+// Publishes the edited AABBs as the collision set and bumps its version
+static void sync_colliders() {
+    tCollidables& colliders = entt::locator<tCollidables>::value();
+    colliders.aabbs.clear();
+    for (const auto& aabb : aabbs) {
+        colliders.aabbs.push_back(aabb.transform);
+    }
+    colliders.version++;
+}
+
+// Rasterizes the static models into the ground heightfield and saves it
+// next to the scene
+static void bake_heightfield(const std::string& filename) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<glm::vec3> triangles;
+    for (auto entity : static_entities) {
+        heightfield_collect_model(ecs.get<Model>(entity), triangles);
+    }
+    Heightfield& field = entt::locator<Heightfield>::value();
+    field = heightfield_bake(triangles, HeightfieldBakeSettings{});
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Heightfield baked: " << field.width << "x" << field.depth << "x" << field.layers
+              << " from " << triangles.size() / 3 << " triangles in " << ms << " ms" << std::endl;
+
+    if (!field.empty() && !field.save(filename)) {
+        std::cerr << "Failed to save heightfield to " << filename << std::endl;
+    }
+}
+
+// Uses the saved heightfield unless the scene was edited after it was baked
+static void load_or_bake_heightfield(const std::string& filename, const std::string& sceneFile) {
+    std::error_code ec;
+    auto baked = std::filesystem::last_write_time(filename, ec);
+    bool fresh = !ec && baked >= std::filesystem::last_write_time(sceneFile, ec) && !ec;
+    if (fresh && entt::locator<Heightfield>::value().load(filename)) {
+        std::cout << "Heightfield loaded from " << filename << std::endl;
+        return;
+    }
+    bake_heightfield(filename);
+}
 
 // === File I/O Functions ===
 static std::string serialize_entities() {
@@ -368,6 +416,8 @@ static void handle_transformations(float dt) {
             transform = glm::scale(transform, scale_vec);
             transform[3] = glm::vec4(position, 1.0f);
         }
+
+        sync_colliders();
     }
 }
 
@@ -389,6 +439,7 @@ static void handle_aabb_management() {
         Camera& camera = entt::locator<Camera>::value();
         glm::mat4 transform = glm::translate(glm::mat4(1.0f), camera.Position + camera.Front);
         aabbs.push_back({.transform = transform});
+        sync_colliders();
     }
 
     if (Input::is_key_just_pressed(GLFW_KEY_DELETE) && !aabbs.empty()) {
@@ -396,6 +447,7 @@ static void handle_aabb_management() {
         if (selected_aabb_index >= aabbs.size() && !aabbs.empty()) {
             selected_aabb_index = aabbs.size() - 1;
         }
+        sync_colliders();
     }
 }
 
@@ -403,113 +455,109 @@ static void handle_file_operations() {
     if (Input::is_key_just_pressed(GLFW_KEY_Y)) {
         save_entities("entities.txt");
         save_aabbs("aabbs.txt");
+        bake_heightfield("heightfield.bin");
     }
 }
 
 // === Rendering ===
+// Restated every frame but only laid out again when a label changes; drawn
+// by game_render's FlushText after every system
 static void render_ui() {
-    Camera& camera = entt::locator<Camera>::value();
-    Meta& meta = entt::locator<Meta>::value();
-    Shaders& shaders = entt::locator<Shaders>::value();
-
     int y = 20;
     const int line_height = 25;
 
-    std::string mode_text = "Mode: ";
+    const char* mode_text = "";
     switch (current_mode) {
-        case TRANSLATION: mode_text += "Translation"; break;
-        case ROTATION: mode_text += "Rotation"; break;
-        case SCALE: mode_text += "Scale"; break;
-        case META: mode_text += "Meta"; break;
-        case AABB_TRANSLATE: mode_text += "AABB Translate"; break;
-        case AABB_ROTATE: mode_text += "AABB Rotate"; break;
-        case AABB_SCALE: mode_text += "AABB Scale"; break;
+        case TRANSLATION: mode_text = "Mode: Translation"; break;
+        case ROTATION: mode_text = "Mode: Rotation"; break;
+        case SCALE: mode_text = "Mode: Scale"; break;
+        case META: mode_text = "Mode: Meta"; break;
+        case AABB_TRANSLATE: mode_text = "Mode: AABB Translate"; break;
+        case AABB_ROTATE: mode_text = "Mode: AABB Rotate"; break;
+        case AABB_SCALE: mode_text = "Mode: AABB Scale"; break;
     }
 
-    std::string dimension_text = "Dimension: ";
+    const char* dimension_text = "";
     switch (current_dimension) {
-        case X: dimension_text += "X"; break;
-        case Y: dimension_text += "Y"; break;
-        case Z: dimension_text += "Z"; break;
+        case X: dimension_text = "Dimension: X"; break;
+        case Y: dimension_text = "Dimension: Y"; break;
+        case Z: dimension_text = "Dimension: Z"; break;
     }
 
-    RenderText(shaders.TEXT, "M: Change mode", 20, y, 0.5f, glm::vec3(1));
+    // Counters are formatted on the stack so a steady frame allocates nothing
+    char buffer[256];
+
+    overlay->begin();
+    overlay->add("M: Change mode", 20, y, 0.5f, glm::vec3(1));
     y += line_height;
-    RenderText(shaders.TEXT, mode_text, 20, y, 0.5f, glm::vec3(1, 1, 0));
+    overlay->add(mode_text, 20, y, 0.5f, glm::vec3(1, 1, 0));
     y += line_height;
-    RenderText(shaders.TEXT, "L: Change dimension", 20, y, 0.5f, glm::vec3(1));
+    overlay->add("L: Change dimension", 20, y, 0.5f, glm::vec3(1));
     y += line_height;
-    RenderText(shaders.TEXT, dimension_text, 20, y, 0.5f, glm::vec3(0, 1, 1));
+    overlay->add(dimension_text, 20, y, 0.5f, glm::vec3(0, 1, 1));
     y += line_height;
 
     if (current_mode == TRANSLATION || current_mode == ROTATION) {
-        RenderText(shaders.TEXT, "I & O: Transform", 20, y, 0.5f, glm::vec3(1));
+        overlay->add("I & O: Transform", 20, y, 0.5f, glm::vec3(1));
         y += line_height;
-        RenderText(shaders.TEXT, "N: Next entity", 20, y, 0.5f, glm::vec3(1));
+        overlay->add("N: Next entity", 20, y, 0.5f, glm::vec3(1));
         y += line_height;
         if (!static_entities.empty()) {
-            std::string entity_text = "Entity: " + std::to_string(selected_entity_index + 1) +
-                                    "/" + std::to_string(static_entities.size());
-            RenderText(shaders.TEXT, entity_text, 20, y, 0.5f, glm::vec3(0, 1, 0));
+            snprintf(buffer, sizeof(buffer), "Entity: %zu/%zu", selected_entity_index + 1, static_entities.size());
+            overlay->add(buffer, 20, y, 0.5f, glm::vec3(0, 1, 0));
             y += line_height;
         }
     }
     else if (current_mode == META) {
-        RenderText(shaders.TEXT, "Y: Save scene", 20, y, 0.5f, glm::vec3(1));
+        overlay->add("Y: Save scene", 20, y, 0.5f, glm::vec3(1));
         y += line_height;
-        std::string add_text = "K: Add ";
-        RenderText(shaders.TEXT, add_text  + resources::path(static_cast<resources::AssetId>(current_add_entity_index)), 20, y, 0.5f, glm::vec3(1));
+        snprintf(buffer, sizeof(buffer), "K: Add %s",
+                 resources::path(static_cast<resources::AssetId>(current_add_entity_index)));
+        overlay->add(buffer, 20, y, 0.5f, glm::vec3(1));
         y += line_height;
-        RenderText(shaders.TEXT, "J: Next add entity", 20, y, 0.5f, glm::vec3(1));
+        overlay->add("J: Next add entity", 20, y, 0.5f, glm::vec3(1));
         y += line_height;
     }
     else if (current_mode == AABB_TRANSLATE || current_mode == AABB_ROTATE || current_mode == AABB_SCALE) {
-        RenderText(shaders.TEXT, "U: Add AABB", 20, y, 0.5f, glm::vec3(1));
+        overlay->add("U: Add AABB", 20, y, 0.5f, glm::vec3(1));
         y += line_height;
-        RenderText(shaders.TEXT, "B: Next AABB", 20, y, 0.5f, glm::vec3(1));
+        overlay->add("B: Next AABB", 20, y, 0.5f, glm::vec3(1));
         y += line_height;
-        RenderText(shaders.TEXT, "Del: Remove AABB", 20, y, 0.5f, glm::vec3(1));
+        overlay->add("Del: Remove AABB", 20, y, 0.5f, glm::vec3(1));
         y += line_height;
 
-        std::string transform_text = "I & O: ";
+        const char* transform_text = "I & O: ";
         switch (current_mode) {
-            case AABB_TRANSLATE: transform_text += "Move AABB"; break;
-            case AABB_ROTATE: transform_text += "Rotate AABB"; break;
-            case AABB_SCALE: transform_text += "Scale AABB"; break;
+            case AABB_TRANSLATE: transform_text = "I & O: Move AABB"; break;
+            case AABB_ROTATE: transform_text = "I & O: Rotate AABB"; break;
+            case AABB_SCALE: transform_text = "I & O: Scale AABB"; break;
+            default: break;
         }
-        RenderText(shaders.TEXT, transform_text, 20, y, 0.5f, glm::vec3(1));
+        overlay->add(transform_text, 20, y, 0.5f, glm::vec3(1));
         y += line_height;
 
         if (!aabbs.empty()) {
-            std::string aabb_text = "AABB: " + std::to_string(selected_aabb_index + 1) +
-                                  "/" + std::to_string(aabbs.size());
-            RenderText(shaders.TEXT, aabb_text, 20, y, 0.5f, glm::vec3(1, 0, 1));
+            snprintf(buffer, sizeof(buffer), "AABB: %zu/%zu", selected_aabb_index + 1, aabbs.size());
+            overlay->add(buffer, 20, y, 0.5f, glm::vec3(1, 0, 1));
             y += line_height;
         }
     }
+    overlay->queue();
 }
+
+
  SkyDome*sky;
+// View and projection come from the frame's uniform block
 static void render_scene() {
-    Camera& camera = entt::locator<Camera>::value();
-    Meta& meta = entt::locator<Meta>::value();
-
-    glm::mat4 projection = glm::perspective(
-        glm::radians(camera.Zoom),
-        meta.WindowDimensions.x / meta.WindowDimensions.y,
-        0.1f, 100.0f
-    );
-    glm::mat4 view = camera.GetViewMatrix();
-    glm::mat4 vp = projection * view;
 
     // Render selected entity's AABB
     if (!static_entities.empty()) {
         const Model& model = ecs.get<Model>(static_entities[selected_entity_index]);
-        std::cout << model.aabbs.size() << '\n';
         for(auto & aabb:model.aabbs) {
-            // renderer->drawAABB(aabb.transform(model.transform), vp);
+            // renderer->drawAABB(aabb.transform(model.transform));
 
         }
-        // renderer->drawAABB(model.aabb.transform(model.transform), vp);
+        // renderer->drawAABB(model.aabb.transform(model.transform));
     }
 
 
@@ -517,19 +565,20 @@ static void render_scene() {
     // Render all AABBs
     for (size_t i = 0; i < aabbs.size(); i++) {
         glm::vec3 color = (i == selected_aabb_index) ? glm::vec3(1, 0, 0) : glm::vec3(1, 1, 0);
-        renderer->drawAABB2(aabbs[i].transform, vp, color);
+        renderer->drawAABB2(aabbs[i].transform, color);
     }
 
 
 
 
-    sky->render(view, projection);
+    sky->render();
 }
 
 // === Public Interface ===
 void static_system_init() {
         sky = new SkyDome("skydom1.jpg");
     renderer = new AABBRenderer();
+    overlay = new TextMesh();
 
     // Load entities
     auto loaded_entities = load_entities("entities.txt");
@@ -549,13 +598,19 @@ void static_system_init() {
 
     // Load AABBs
     auto loaded_aabb_transforms = load_aabbs("aabbs.txt");
-        tCollidables colliders;
     for (const auto& transform : loaded_aabb_transforms) {
         aabbs.push_back({.transform = transform});
-        colliders.aabbs.push_back(transform);
     }
 
-    entt::locator<tCollidables>::emplace(colliders);
+    if (!entt::locator<tCollidables>::has_value()) {
+        entt::locator<tCollidables>::emplace();
+    }
+    sync_colliders();
+
+    if (!entt::locator<Heightfield>::has_value()) {
+        entt::locator<Heightfield>::emplace();
+    }
+    load_or_bake_heightfield("heightfield.bin", "entities.txt");
 
 
     // Create ground plane
@@ -0,0 +1,127 @@
+#include "system_scheduler.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+std::chrono::steady_clock::time_point timeline_epoch() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return epoch;
+}
+
+static double timeline_now() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - timeline_epoch()).count();
+}
+
+static bool overlaps(const std::vector<AccessId>& a, const std::vector<AccessId>& b) {
+    for (AccessId id : a) {
+        if (std::find(b.begin(), b.end(), id) != b.end()) return true;
+    }
+    return false;
+}
+
+void SystemScheduler::add(SystemDesc desc) {
+    systems.push_back(std::move(desc));
+    dirty = true;
+}
+
+void SystemScheduler::set_enabled(const std::string& systemName, bool enabled) {
+    for (auto& system : systems) {
+        if (system.name == systemName) system.enabled = enabled;
+    }
+}
+
+void SystemScheduler::build() {
+    size_t count = systems.size();
+    dependents.assign(count, {});
+    dependencies.assign(count, {});
+    remaining = std::make_unique<std::atomic<int>[]>(count);
+    timeline.assign(count, {});
+
+    for (size_t later = 0; later < count; later++) {
+        const SystemDesc& b = systems[later];
+        for (size_t earlier = 0; earlier < later; earlier++) {
+            const SystemDesc& a = systems[earlier];
+            if (overlaps(a.writes, b.reads) || overlaps(a.writes, b.writes) || overlaps(b.writes, a.reads)) {
+                dependents[earlier].push_back(later);
+                dependencies[later].push_back(earlier);
+            }
+        }
+    }
+    dirty = false;
+}
+
+std::vector<std::string> SystemScheduler::describe() {
+    if (dirty) build();
+
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < systems.size(); i++) {
+        std::string line = systems[i].name + (systems[i].mainThread ? " [main]" : "") + " <-";
+        for (size_t dependency : dependencies[i]) line += " " + systems[dependency].name;
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+void SystemScheduler::launch(JobSystem& jobs, JobCounter& frame, size_t index, float dt) {
+    JobAffinity affinity = systems[index].mainThread ? JobAffinity::Main : JobAffinity::Any;
+    jobs.run([this, &jobs, &frame, index, dt] {
+        const SystemDesc& system = systems[index];
+        TimelineEvent& event = timeline[index];
+        event.slot = jobs.current_slot();
+        event.start = timeline_now();
+        if (system.enabled) system.fn(dt);
+        event.end = timeline_now();
+
+        // Queued before this job retires, so frame cannot drain early
+        for (size_t next : dependents[index]) {
+            if (remaining[next].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                launch(jobs, frame, next, dt);
+            }
+        }
+    }, &frame, affinity);
+}
+
+void SystemScheduler::run(JobSystem& jobs, float dt) {
+    if (dirty) build();
+
+    for (size_t i = 0; i < systems.size(); i++) {
+        remaining[i].store(static_cast<int>(dependencies[i].size()), std::memory_order_relaxed);
+    }
+
+    JobCounter frame;
+    for (size_t i = 0; i < systems.size(); i++) {
+        if (dependencies[i].empty()) launch(jobs, frame, i, dt);
+    }
+    jobs.wait(frame);
+}
+
+bool export_timeline(const std::string& path, const std::vector<const SystemScheduler*>& schedulers) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write timeline to " << path << std::endl;
+        return false;
+    }
+
+    file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+    bool first = true;
+    for (size_t pid = 0; pid < schedulers.size(); pid++) {
+        const SystemScheduler& scheduler = *schedulers[pid];
+        file << (first ? "" : ",") << "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+             << ",\"args\":{\"name\":\"" << scheduler.getName() << "\"}}";
+        first = false;
+
+        const auto& timeline = scheduler.getTimeline();
+        for (size_t i = 0; i < timeline.size(); i++) {
+            const SystemDesc& system = scheduler.getSystem(i);
+            if (!system.enabled) continue;
+            file << ",\n{\"name\":\"" << system.name << "\",\"ph\":\"X\",\"pid\":" << pid
+                 << ",\"tid\":" << timeline[i].slot << ",\"ts\":" << timeline[i].start
+                 << ",\"dur\":" << timeline[i].end - timeline[i].start << "}";
+        }
+    }
+    file << "\n]}\n";
+
+    std::cout << "Timeline written to " << path << std::endl;
+    return file.good();
+}
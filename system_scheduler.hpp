@@ -0,0 +1,78 @@
+#pragma once
+#include "job_system.hpp"
+#include <chrono>
+#include <entt/entt.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Identifies a component or singleton a system touches
+using AccessId = entt::id_type;
+
+template <typename... T>
+std::vector<AccessId> access() {
+    return {entt::type_hash<T>::value()...};
+}
+
+struct SystemDesc {
+    std::string name;
+    std::function<void(float)> fn;
+    std::vector<AccessId> reads;
+    std::vector<AccessId> writes;
+    bool mainThread = false; // touches GL, must run on the thread owning the context
+    bool enabled = true;
+};
+
+// Runs a set of systems once per call, in parallel wherever their access
+// sets allow. Two systems conflict when one writes something the other
+// reads or writes; conflicting systems keep their registration order and
+// everything else is free to overlap on the job system.
+class SystemScheduler {
+public:
+    explicit SystemScheduler(std::string name) : name(std::move(name)) {}
+
+    void add(SystemDesc desc);
+    void set_enabled(const std::string& systemName, bool enabled);
+
+    void run(JobSystem& jobs, float dt);
+
+    const std::string& getName() const { return name; }
+
+    // Names of the systems each system waits for, for debugging the graph;
+    // builds the graph first if systems were added since the last build
+    std::vector<std::string> describe();
+
+    // One entry per system from the last run, in microseconds since
+    // timeline_epoch(), with the job slot it ran on
+    struct TimelineEvent {
+        double start = 0.0;
+        double end = 0.0;
+        unsigned int slot = 0;
+    };
+    const std::vector<TimelineEvent>& getTimeline() const { return timeline; }
+    const SystemDesc& getSystem(size_t index) const { return systems[index]; }
+    size_t size() const { return systems.size(); }
+
+private:
+    void build();
+    void launch(JobSystem& jobs, JobCounter& frame, size_t index, float dt);
+
+    std::string name;
+    std::vector<SystemDesc> systems;
+
+    // Graph, rebuilt when systems are added
+    bool dirty = true;
+    std::vector<std::vector<size_t>> dependents;
+    std::vector<std::vector<size_t>> dependencies;
+    std::unique_ptr<std::atomic<int>[]> remaining;
+
+    std::vector<TimelineEvent> timeline;
+};
+
+std::chrono::steady_clock::time_point timeline_epoch();
+
+// Writes the last run of every scheduler as a Chrome trace
+// (chrome://tracing or ui.perfetto.dev), one process per scheduler and one
+// track per job slot
+bool export_timeline(const std::string& path, const std::vector<const SystemScheduler*>& schedulers);
@@ -0,0 +1,272 @@
+#include "tests.hpp"
+#include "collider_store.hpp"
+#include "collision_system.hpp"
+#include "narrowphase.hpp"
+#include "sdf.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::fprintf(stderr, "  FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static bool near(float a, float b, float tolerance) {
+    return std::fabs(a - b) <= tolerance;
+}
+
+static bool near(const glm::vec3& a, const glm::vec3& b, float tolerance) {
+    return glm::length(a - b) <= tolerance;
+}
+
+static OBB unit_box() {
+    return OBB::fromTransform(glm::mat4(1.0f), 1.0f);
+}
+
+// Distance from a point to the box, by clamping in box space
+static float point_obb_distance(const glm::vec3& p, const OBB& box) {
+    glm::vec3 local = box.toLocal(p);
+    return glm::length(local - glm::clamp(local, -box.halfExtents, box.halfExtents));
+}
+
+// === Narrowphase ===
+static void test_segment_distance() {
+    OBB box = unit_box();
+    glm::vec3 onSegment, onBox;
+
+    // Segment beside the +x face, crossing the whole y slab
+    float distSq = segment_obb_distance_sq(glm::vec3(2, -5, 0), glm::vec3(2, 5, 0), box, onSegment, onBox);
+    CHECK(near(distSq, 1.0f, 1e-5f));
+    CHECK(near(onBox.x, 1.0f, 1e-5f));
+    CHECK(near(onSegment.x, 2.0f, 1e-5f));
+
+    // Segment through the box
+    distSq = segment_obb_distance_sq(glm::vec3(-3, 0.2f, 0), glm::vec3(3, 0.2f, 0), box, onSegment, onBox);
+    CHECK(distSq == 0.0f);
+
+    // Segment skew to a corner: closest pair is the edge corner (1, 1, z)
+    distSq = segment_obb_distance_sq(glm::vec3(3, 1, -2), glm::vec3(1, 3, 2), box, onSegment, onBox);
+    CHECK(near(distSq, 2.0f, 1e-4f));
+    CHECK(near(onBox, glm::vec3(1, 1, 0), 1e-3f));
+
+    // Rotated box against a dense sampling of the segment: the exact answer
+    // can only be at or below the best sample
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (int i = 0; i < 200; i++) {
+        glm::mat4 m = glm::rotate(glm::mat4(1.0f), unit(gen) * 3.14159f,
+                                  glm::normalize(glm::vec3(unit(gen), 1.0f, unit(gen))));
+        m = glm::scale(m, glm::vec3(1.0f + unit(gen) * 0.5f, 1.0f + unit(gen) * 0.5f, 0.5f + unit(gen) * 0.25f));
+        OBB rotated = OBB::fromTransform(m, 1.0f);
+        glm::vec3 a(unit(gen) * 3.0f, unit(gen) * 3.0f, unit(gen) * 3.0f);
+        glm::vec3 b(unit(gen) * 3.0f, unit(gen) * 3.0f, unit(gen) * 3.0f);
+
+        float sampled = INFINITY;
+        const int samples = 2000;
+        for (int s = 0; s <= samples; s++) {
+            sampled = std::min(sampled, point_obb_distance(glm::mix(a, b, float(s) / samples), rotated));
+        }
+        float exact = std::sqrt(segment_obb_distance_sq(a, b, rotated, onSegment, onBox));
+        CHECK(exact <= sampled + 1e-4f);
+        CHECK(exact >= sampled - glm::length(b - a) / samples - 1e-4f);
+        CHECK(near(glm::length(onSegment - onBox), exact, 1e-4f));
+    }
+}
+
+static void test_capsule_contact() {
+    OBB box = unit_box();
+    Contact contact;
+
+    // Lower sphere sunk 0.1 into the top face
+    CHECK(capsule_obb_contact({glm::vec3(0, 1.15f, 0), glm::vec3(0, 2, 0), 0.25f}, box, contact));
+    CHECK(near(contact.normal, glm::vec3(0, 1, 0), 1e-5f));
+    CHECK(near(contact.depth, 0.1f, 1e-5f));
+
+    // Just clear of the top face
+    CHECK(!capsule_obb_contact({glm::vec3(0, 1.26f, 0), glm::vec3(0, 2, 0), 0.25f}, box, contact));
+
+    // Segment inside the box near the +x face: pushed out through that face
+    CHECK(capsule_obb_contact({glm::vec3(0.9f, -0.2f, 0), glm::vec3(0.9f, 0.2f, 0), 0.25f}, box, contact));
+    CHECK(near(contact.normal, glm::vec3(1, 0, 0), 1e-5f));
+    CHECK(near(contact.depth, 0.35f, 1e-5f));
+}
+
+static void test_sweep() {
+    OBB box = unit_box();
+    SweepHit hit;
+    const float tolerance = 2e-4f;
+
+    // Head-on: the sphere touches the +x face after travelling 3.5 of 10
+    CHECK(sweep_capsule_obb({glm::vec3(5, 0, 0), glm::vec3(5, 0, 0), 0.5f}, glm::vec3(-10, 0, 0), box, hit));
+    CHECK(hit.t <= 0.35f && hit.t > 0.35f - tolerance);
+    CHECK(near(hit.normal, glm::vec3(1, 0, 0), 1e-4f));
+
+    // Clear miss
+    CHECK(!sweep_capsule_obb({glm::vec3(5, 3, 0), glm::vec3(5, 3, 0), 0.5f}, glm::vec3(-10, 0, 0), box, hit));
+
+    // t = 0: already touching. Moving in is a hit, moving away is not.
+    Capsule touching{glm::vec3(0, 1.5f, 0), glm::vec3(0, 2, 0), 0.5f};
+    CHECK(sweep_capsule_obb(touching, glm::vec3(0, -1, 0), box, hit));
+    CHECK(hit.t == 0.0f);
+    CHECK(near(hit.normal, glm::vec3(0, 1, 0), 1e-4f));
+    CHECK(!sweep_capsule_obb(touching, glm::vec3(0, 1, 0), box, hit));
+
+    // Grazing the top edge: 0.01 of overlap is enough to be caught at the
+    // corner, before the sphere would pass over the face
+    float radius = 0.5f;
+    float dx = std::sqrt(radius * radius - (radius - 0.01f) * (radius - 0.01f));
+    float expected = (5.0f - 1.0f - dx) / 10.0f;
+    glm::vec3 start(-5, 1 + radius - 0.01f, 0);
+    CHECK(sweep_capsule_obb({start, start, radius}, glm::vec3(10, 0, 0), box, hit));
+    CHECK(hit.t <= expected && hit.t > expected - 0.01f);
+
+    // Near-parallel approach that exhausts the iteration budget: still a
+    // hit, no later than the true time of impact
+    start = glm::vec3(-1, 1 + radius + 0.015f, 0);
+    CHECK(sweep_capsule_obb({start, start, radius}, glm::vec3(10, -0.02f, 0), box, hit));
+    CHECK(hit.t <= (0.015f - 1e-3f) / 0.02f);
+    CHECK(near(hit.normal, glm::vec3(0, 1, 0), 1e-3f));
+
+    // Rotated box: 45 degrees about z puts an edge on top at y = sqrt(2)
+    OBB rotated = OBB::fromTransform(glm::rotate(glm::mat4(1.0f), 0.7853982f, glm::vec3(0, 0, 1)), 1.0f);
+    expected = (5.0f - std::sqrt(2.0f) - 0.5f) / 10.0f;
+    CHECK(sweep_capsule_obb({glm::vec3(0, 5, 0), glm::vec3(0, 5, 0), 0.5f}, glm::vec3(0, -10, 0), rotated, hit));
+    CHECK(hit.t <= expected && hit.t > expected - tolerance);
+    CHECK(near(hit.normal, glm::vec3(0, 1, 0), 1e-3f));
+}
+
+// Sprint at a 5 cm thick rotated wall on a 30 Hz tick. Each step moves 2 m,
+// forty times the wall thickness.
+static void test_tunneling() {
+    tCollidables wall;
+    glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, -10.0f));
+    m = glm::rotate(m, 0.3f, glm::vec3(0, 1, 0));
+    wall.aabbs.push_back(glm::scale(m, glm::vec3(50.0f, 2.0f, 0.025f)));
+    ColliderStore store;
+    store.sync(wall);
+
+    PlayerShape shape;
+    glm::vec3 position(0.0f, 1.0f, 0.0f);
+    const float tick = 1.0f / 30.0f;
+    for (int step = 0; step < 30; step++) {
+        position = collision_move_and_slide(store, shape, position, glm::vec3(0.0f, 0.0f, -60.0f) * tick);
+
+        glm::vec3 local = store.getOBB(0).toLocal(position);
+        CHECK(local.z > 0.0f);
+    }
+
+    // Stopped against the wall and slid along it rather than sticking
+    glm::vec3 local = store.getOBB(0).toLocal(position);
+    CHECK(local.z < 0.025f + shape.radius + 0.01f);
+    CHECK(std::fabs(position.x) > 1.0f);
+}
+
+// === Distance fields ===
+// Coverage of a shape with a known distance function (positive inside),
+// 4x4 supersampled like a FreeType bitmap, turned into a field and checked
+// against the exact distances near the outline
+static void check_sdf_shape(const char* name, const std::function<float(float, float)>& distance) {
+    const int size = 128, downsample = 4, spread = 4;
+    std::vector<unsigned char> coverage(size * size);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            int hits = 0;
+            for (int sy = 0; sy < 4; sy++) {
+                for (int sx = 0; sx < 4; sx++) hits += distance(x + (sx + 0.5f) / 4.0f, y + (sy + 0.5f) / 4.0f) > 0.0f;
+            }
+            coverage[y * size + x] = static_cast<unsigned char>(hits * 255 / 16);
+        }
+    }
+
+    DistanceField field;
+    build_distance_field(coverage.data(), size, size, size, downsample, spread, field);
+    CHECK(field.width == size / downsample + 2 * spread && field.height == field.width);
+    CHECK(field.padding == spread);
+
+    // Exact distance at each field texel's centre, in field texels
+    float maxError = 0.0f;
+    int samples = 0, wrongSide = 0;
+    for (int y = 0; y < field.height; y++) {
+        for (int x = 0; x < field.width; x++) {
+            float sx = (x - field.padding + 0.5f) * downsample;
+            float sy = (y - field.padding + 0.5f) * downsample;
+            float exact = distance(sx, sy) / downsample;
+            if (std::fabs(exact) > spread - 1) continue;
+            float got = distance_field_decode(field.pixels[y * field.width + x], spread);
+            maxError = std::max(maxError, std::fabs(got - exact));
+            samples++;
+            if (std::fabs(exact) > 0.25f && (got > 0.0f) != (exact > 0.0f)) wrongSide++;
+        }
+    }
+    if (maxError >= 0.3f || wrongSide > 0) {
+        std::fprintf(stderr, "  %s: max error %.3f texels, %d wrong side\n", name, maxError, wrongSide);
+    }
+    CHECK(samples > 0);
+    CHECK(maxError < 0.3f);
+    CHECK(wrongSide == 0);
+}
+
+static void test_sdf() {
+    check_sdf_shape("circle", [](float x, float y) { return 50.0f - std::hypot(x - 64.0f, y - 64.0f); });
+    check_sdf_shape("square", [](float x, float y) {
+        float dx = std::fabs(x - 64.0f) - 40.0f, dy = std::fabs(y - 64.0f) - 40.0f;
+        float outside = std::hypot(std::max(dx, 0.0f), std::max(dy, 0.0f));
+        return -(outside + std::min(std::max(dx, dy), 0.0f));
+    });
+    check_sdf_shape("ring", [](float x, float y) {
+        return 8.0f - std::fabs(std::hypot(x - 64.0f, y - 64.0f) - 40.0f);
+    });
+
+    // Nothing drawn, such as a space: an empty field, whatever was there
+    DistanceField field;
+    field.width = field.height = field.padding = 3;
+    field.pixels.assign(9, 128);
+    build_distance_field(nullptr, 0, 0, 0, 4, 4, field);
+    CHECK(field.width == 0 && field.height == 0 && field.padding == 0);
+    CHECK(field.pixels.empty());
+}
+
+struct TestEntry {
+    const char* name;
+    void (*fn)();
+};
+
+static const TestEntry tests[] = {
+    {"segment_distance", test_segment_distance},
+    {"capsule_contact", test_capsule_contact},
+    {"sweep", test_sweep},
+    {"tunneling", test_tunneling},
+    {"sdf", test_sdf},
+};
+
+int run_tests(const std::string& name) {
+    bool found = false;
+    for (const auto& test : tests) {
+        if (name == "all" || name == test.name) {
+            int before = failures;
+            test.fn();
+            std::cout << (failures == before ? "pass " : "FAIL ") << test.name << std::endl;
+            found = true;
+        }
+    }
+
+    if (!found) {
+        std::cerr << "Unknown test: " << name << "\nAvailable:";
+        for (const auto& test : tests) {
+            std::cerr << " " << test.name;
+        }
+        std::cerr << " all" << std::endl;
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <string>
+
+// Headless correctness checks, run with `./bin --test <name>` (or `all`).
+// Like the benchmarks they need no window or GL context. The exit status is
+// non-zero if any check fails, so they can gate a build.
+int run_tests(const std::string& name);
@@ -1,146 +1,287 @@
 #include "text_renderer.hpp"
 #include "shader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
-std::map<GLchar, Character> Characters;
+GlyphAtlas TextGlyphs;
 unsigned int _VAO, _VBO;
 
-void RenderText(unsigned int shader, std::string text, float x, float y, float scale, glm::vec3 color)
+static const char* FONT_PATH = "resources/fonts/Antonio-Bold.ttf";
+// Distance fields of every glyph rasterized so far, so later runs skip FreeType
+static const char* GLYPH_CACHE_PATH = "glyphs.bin";
+
+// Glyph quads queued since the last flush, for every string and colour
+static std::vector<TextVertex> textVertices;
+static size_t queuedStrings = 0;
+// Size of _VBO's store; it only grows
+static size_t textBufferBytes = 0;
+// Retained meshes to draw in the next flush
+static std::vector<TextMesh*> queuedMeshes;
+
+static TextStats frameStats;
+static TextStats lastFrameStats;
+
+// Codepoint starting at text[i], advancing i past it. Malformed UTF-8
+// gives U+FFFD and skips one byte.
+static uint32_t next_codepoint(std::string_view text, size_t& i)
 {
-    // activate corresponding render state
+    unsigned char lead = static_cast<unsigned char>(text[i++]);
+    if (lead < 0x80)
+        return lead;
 
-    Shader::Use(shader);
-    glUniform3f(glGetUniformLocation(shader, "textColor"), color.x, color.y, color.z);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(_VAO);
+    int length = lead >= 0xf0 ? 3 : lead >= 0xe0 ? 2 : lead >= 0xc0 ? 1 : -1;
+    if (length < 0 || i + length > text.size())
+        return 0xfffd;
+    uint32_t codepoint = lead & (0x3f >> length);
+    for (int k = 0; k < length; k++)
+    {
+        unsigned char next = static_cast<unsigned char>(text[i + k]);
+        if ((next & 0xc0) != 0x80)
+            return 0xfffd;
+        codepoint = (codepoint << 6) | (next & 0x3f);
+    }
+    i += length;
+    return codepoint;
+}
 
+// Appends the string's glyph quads, starting at the baseline point x, y,
+// and the atlas shelves they sit on to shelves if given. False if a glyph
+// was left out for lack of atlas room or a font.
+static bool layout_text(std::vector<TextVertex>& out, std::string_view text, float x, float y, float scale,
+                        glm::vec3 color, std::vector<int>* shelves = nullptr)
+{
+    const unsigned char rgba[4] = {
+        static_cast<unsigned char>(std::clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f),
+        static_cast<unsigned char>(std::clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f),
+        static_cast<unsigned char>(std::clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f),
+        255};
+
+    bool complete = true;
     // iterate through all characters
-    std::string::const_iterator c;
-    for (c = text.begin(); c != text.end(); c++)
+    for (size_t i = 0; i < text.size();)
     {
-        Character ch = Characters[*c];
+        int shelf = -1;
+        const Character* glyph = TextGlyphs.find(next_codepoint(text, i), &shelf);
+        if (!glyph)
+        {
+            complete = false;
+            continue;
+        }
+        if (shelves && shelf >= 0)
+            shelves->push_back(shelf);
+        const Character& ch = *glyph;
 
         float xpos = x + ch.Bearing.x * scale;
         float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
 
         float w = ch.Size.x * scale;
         float h = ch.Size.y * scale;
-        // update VBO for each character
-        float vertices[6][4] = {
-            {xpos, ypos + h, 0.0f, 0.0f},
-            {xpos, ypos, 0.0f, 1.0f},
-            {xpos + w, ypos, 1.0f, 1.0f},
-
-            {xpos, ypos + h, 0.0f, 0.0f},
-            {xpos + w, ypos, 1.0f, 1.0f},
-            {xpos + w, ypos + h, 1.0f, 0.0f}};
-        // render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        // update content of VBO memory
-        glBindBuffer(GL_ARRAY_BUFFER, _VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // be sure to use glBufferSubData and not glBufferData
+        float u0 = ch.UVMin.x, v0 = ch.UVMin.y, u1 = ch.UVMax.x, v1 = ch.UVMax.y;
+        const TextVertex quad[6] = {
+            {xpos, ypos + h, u0, v0, {rgba[0], rgba[1], rgba[2], rgba[3]}},
+            {xpos, ypos, u0, v1, {rgba[0], rgba[1], rgba[2], rgba[3]}},
+            {xpos + w, ypos, u1, v1, {rgba[0], rgba[1], rgba[2], rgba[3]}},
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // render quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        // now advance cursors for next glyph (note that advance is number of 1/64 pixels)
-        x += (ch.Advance >> 6) * scale; // bitshift by 6 to get value in pixels (2^6 = 64 (divide amount of 1/64th pixels by 64 to get amount of pixels))
+            {xpos, ypos + h, u0, v0, {rgba[0], rgba[1], rgba[2], rgba[3]}},
+            {xpos + w, ypos, u1, v1, {rgba[0], rgba[1], rgba[2], rgba[3]}},
+            {xpos + w, ypos + h, u1, v0, {rgba[0], rgba[1], rgba[2], rgba[3]}}};
+        out.insert(out.end(), quad, quad + 6);
+        // now advance cursors for next glyph
+        x += ch.Advance * scale;
     }
+    return complete;
+}
+
+// Vertex layout of TextVertex for the VAO bound with vbo
+static void setup_text_attributes(unsigned int vao, unsigned int vbo)
+{
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, x));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(TextVertex), (void*)offsetof(TextVertex, color));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void text_init(unsigned int shader, int width, int height)
+void QueueText(const std::string& text, float x, float y, float scale, glm::vec3 color)
 {
+    layout_text(textVertices, text, x, y, scale, color);
+    queuedStrings++;
+}
+
+void FlushText(unsigned int shader)
+{
+    if (textVertices.empty() && queuedMeshes.empty())
+    {
+        queuedStrings = 0;
+        return;
+    }
 
-    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height));
+    // Meshes whose labels changed, or whose shelves were emptied by an
+    // eviction, are laid out again. Every queued mesh marked its shelves
+    // used in queue(), so laying one out can't evict the glyphs of another.
+    for (TextMesh* mesh : queuedMeshes)
+    {
+        if (mesh->dirty || TextGlyphs.evictedSince(mesh->shelves, mesh->atlasGeneration))
+            mesh->rebuild();
+    }
+
+    // activate corresponding render state
     Shader::Use(shader);
-    glUniformMatrix4fv(glGetUniformLocation(shader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, TextGlyphs.texture());
 
-    // FreeType
-    // --------
-    FT_Library ft;
-    // All functions return a value different than 0 whenever an error occurred
-    if (FT_Init_FreeType(&ft))
+    for (const TextMesh* mesh : queuedMeshes)
     {
-        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-        // return -1;
+        if (mesh->vertexCount == 0)
+            continue;
+        glBindVertexArray(mesh->vao);
+        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(mesh->vertexCount));
+        frameStats.glyphs += mesh->glyphCount();
+        frameStats.strings += mesh->labels.size();
+        frameStats.drawCalls++;
     }
+    queuedMeshes.clear();
 
-    // find path to font
-    std::string font_name = "Antonia-Bold.ttf"; // std::filesystem::fiel("resources/fonts/Antonio-Bold.ttf");
-    // if (font_name.empty())
-    // {
-    //     std::cout << "ERROR::FREETYPE: Failed to load font_name" << std::endl;
-    //     return -1;
-    // }
-
-    // load font as face
-    FT_Face face;
-    if (FT_New_Face(ft, "resources/fonts/Antonio-Bold.ttf", 0, &face))
+    if (!textVertices.empty())
     {
-        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
-        // return -1;
+        glBindVertexArray(_VAO);
+
+        // Orphan the store before writing, so the driver never waits on the
+        // last flush still reading it
+        size_t bytes = textVertices.size() * sizeof(TextVertex);
+        textBufferBytes = std::max(textBufferBytes, bytes);
+        glBindBuffer(GL_ARRAY_BUFFER, _VBO);
+        glBufferData(GL_ARRAY_BUFFER, textBufferBytes, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, textVertices.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(textVertices.size()));
+
+        frameStats.glyphs += textVertices.size() / 6;
+        frameStats.strings += queuedStrings;
+        frameStats.drawCalls++;
+        frameStats.uploadBytes += bytes;
+        textVertices.clear();
     }
-    else
+    queuedStrings = 0;
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void RenderText(unsigned int shader, std::string text, float x, float y, float scale, glm::vec3 color)
+{
+    QueueText(text, x, y, scale, color);
+    FlushText(shader);
+}
+
+TextMesh::~TextMesh()
+{
+    if (vao)
     {
-        // set size to load glyphs as
-        FT_Set_Pixel_Sizes(face, 0, 48);
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &vbo);
+    }
+}
 
-        // disable byte-alignment restriction
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+void TextMesh::begin()
+{
+    cursor = 0;
+}
 
-        // load first 128 characters of ASCII set
-        for (unsigned char c = 0; c < 128; c++)
+void TextMesh::add(std::string_view text, float x, float y, float scale, glm::vec3 color)
+{
+    if (cursor == labels.size())
+    {
+        labels.push_back({std::string(text), x, y, scale, color});
+        dirty = true;
+    }
+    else
+    {
+        Label& label = labels[cursor];
+        if (label.text != text || label.x != x || label.y != y || label.scale != scale || label.color != color)
         {
-            // Load character glyph
-            if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-            {
-                std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-                continue;
-            }
-            // generate texture
-            unsigned int texture;
-            glGenTextures(1, &texture);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            glTexImage2D(
-                GL_TEXTURE_2D,
-                0,
-                GL_RED,
-                face->glyph->bitmap.width,
-                face->glyph->bitmap.rows,
-                0,
-                GL_RED,
-                GL_UNSIGNED_BYTE,
-                face->glyph->bitmap.buffer);
-            // set texture options
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            // now store character for later use
-            Character character = {
-                texture,
-                glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-                glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-                static_cast<unsigned int>(face->glyph->advance.x)};
-            Characters.insert(std::pair<char, Character>(c, character));
+            label = {std::string(text), x, y, scale, color};
+            dirty = true;
         }
-        glBindTexture(GL_TEXTURE_2D, 0);
     }
-    // destroy FreeType once we're finished
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    cursor++;
+}
+
+void TextMesh::queue()
+{
+    if (cursor < labels.size())
+    {
+        labels.resize(cursor);
+        dirty = true;
+    }
+    // A clean mesh never calls find, so keep its glyphs from looking unused
+    TextGlyphs.touch(shelves);
+    queuedMeshes.push_back(this);
+}
+
+void TextMesh::rebuild()
+{
+    static std::vector<TextVertex> vertices;
+    vertices.clear();
+    shelves.clear();
+    bool complete = true;
+    for (const Label& label : labels)
+        complete &= layout_text(vertices, label.text, label.x, label.y, label.scale, label.color, &shelves);
+    std::sort(shelves.begin(), shelves.end());
+    shelves.erase(std::unique(shelves.begin(), shelves.end()), shelves.end());
+
+    if (!vao)
+    {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        setup_text_attributes(vao, vbo);
+    }
+    size_t bytes = vertices.size() * sizeof(TextVertex);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, bytes, vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    vertexCount = vertices.size();
+    // try again next frame for glyphs that didn't fit
+    dirty = !complete;
+    atlasGeneration = TextGlyphs.generation();
+    frameStats.meshRebuilds++;
+    frameStats.uploadBytes += bytes;
+}
+
+void text_end_frame()
+{
+    TextGlyphs.endFrame();
+    frameStats.atlas = TextGlyphs.getStats();
+    lastFrameStats = frameStats;
+    frameStats = {};
+}
+
+const TextStats& text_stats()
+{
+    return lastFrameStats;
+}
+
+void text_init()
+{
+    // Glyphs are made as strings first use them; only the cache is read here
+    auto start = std::chrono::steady_clock::now();
+    TextGlyphs.init(FONT_PATH, GLYPH_CACHE_PATH);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    const GlyphAtlasStats& atlas = TextGlyphs.getStats();
+    std::cout << "Text: ready in " << elapsed.count() << " ms, " << atlas.fromCache << " glyphs in the cache, "
+              << GlyphAtlas::WIDTH << "x" << GlyphAtlas::HEIGHT << " atlas" << std::endl;
 
     // configure VAO/VBO for texture quads
     // -----------------------------------
     glGenVertexArrays(1, &_VAO);
     glGenBuffers(1, &_VBO);
-    glBindVertexArray(_VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, _VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    setup_text_attributes(_VAO, _VBO);
 }
@@ -1,23 +1,87 @@
 #pragma once
-#include <map>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "glyph_atlas.hpp"
 #include "mygl.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
 
-#include <ft2build.h>
-#include FT_FREETYPE_H
+// Glyphs for every string drawn, made on first use; metrics are in pixels
+// at RenderText scale 1
+extern GlyphAtlas TextGlyphs;
+extern unsigned int _VAO, _VBO;
 
-/// Holds all state information relevant to a character as loaded using FreeType
-struct Character
+// One corner of a glyph quad: screen position, atlas UV and the string's colour
+struct TextVertex
 {
-    unsigned int TextureID; // ID handle of the glyph texture
-    glm::ivec2 Size;        // Size of glyph
-    glm::ivec2 Bearing;     // Offset from baseline to left/top of glyph
-    unsigned int Advance;   // Horizontal offset to advance to next glyph
+    float x, y, u, v;
+    unsigned char color[4];
 };
 
-extern std::map<GLchar, Character> Characters;
-extern unsigned int _VAO, _VBO;
+// Text drawn over one frame
+struct TextStats
+{
+    size_t glyphs = 0;
+    size_t strings = 0;
+    size_t drawCalls = 0;
+    size_t uploadBytes = 0;
+    size_t meshRebuilds = 0; // TextMeshes laid out again because a label changed or glyphs moved
+    GlyphAtlasStats atlas;
+};
+
+// Labels laid out once and kept in their own vertex buffer, for text that
+// rarely changes. Each frame the owner restates the labels between begin()
+// and queue(); only when one differs from last frame (string, position,
+// scale or colour, or a label added or dropped) is the mesh laid out and
+// uploaded again. Use QueueText for text that changes every frame.
+class TextMesh
+{
+public:
+    TextMesh() = default;
+    TextMesh(const TextMesh&) = delete;
+    TextMesh& operator=(const TextMesh&) = delete;
+    ~TextMesh();
+
+    void begin();
+    void add(std::string_view text, float x, float y, float scale, glm::vec3 color);
+    // Ends the labels and draws the mesh in the next FlushText, rebuilding it first if needed
+    void queue();
+
+    size_t glyphCount() const { return vertexCount / 6; }
+
+private:
+    struct Label
+    {
+        std::string text;
+        float x, y, scale;
+        glm::vec3 color;
+    };
+
+    void rebuild();
+
+    std::vector<Label> labels;
+    size_t cursor = 0;
+    bool dirty = true;
+    uint32_t atlasGeneration = 0; // of TextGlyphs when last laid out
+    std::vector<int> shelves;     // atlas shelves the layout uses, kept alive while queued
+    unsigned int vao = 0, vbo = 0;
+    size_t vertexCount = 0;
+
+    friend void FlushText(unsigned int shader);
+};
 
+// Lays the UTF-8 string out into the frame's text batch; nothing is drawn until FlushText
+void QueueText(const std::string& text, float x, float y, float scale, glm::vec3 color);
+// Draws the queued TextMeshes, one call each, then everything queued since
+// the last flush with one upload and one draw call
+void FlushText(unsigned int shader);
+// Queues the string and flushes straight away, along with anything queued before it
 void RenderText(unsigned int shader, std::string text, float x, float y, float scale, glm::vec3 color);
-void text_init(unsigned int shader, int width, int height);
+// Closes the frame's text stats; text_stats() returns them until the next frame ends
+void text_end_frame();
+const TextStats& text_stats();
+// Text is positioned in pixels from the bottom left of the window, which
+// the shader takes from the frame's uniform block
+void text_init();